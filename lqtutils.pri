@@ -28,10 +28,18 @@ QT += androidextras
 SOURCES += \
     $$PWD/lqtutils_ui.cpp \
     $$PWD/lqtutils_freq.cpp \
+    $$PWD/lqtutils_qmonitor.cpp \
+    $$PWD/lqtutils_qconsumer.cpp \
+    $$PWD/lqtutils_timerwheel.cpp \
+    $$PWD/lqtutils_ratelimit.cpp \
     $$PWD/lqtutils_fa.cpp
 HEADERS += \
     $$PWD/lqtutils_ui.h \
     $$PWD/lqtutils_freq.h \
+    $$PWD/lqtutils_qmonitor.h \
+    $$PWD/lqtutils_qconsumer.h \
+    $$PWD/lqtutils_timerwheel.h \
+    $$PWD/lqtutils_ratelimit.h \
     $$PWD/lqtutils_fa.h
 ios {
 SOURCES += $$PWD/lqtutils_ui.mm
@@ -0,0 +1,522 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Luca Carlon
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#include <QTest>
+#include <QThread>
+#include <QTimer>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QFuture>
+#include <QtConcurrentRun>
+
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <optional>
+#include <vector>
+
+#include "../lqtutils_function.h"
+#include "../lqtutils_autoexec.h"
+#include "../lqtutils_perf.h"
+#include "../lqtutils_bqueue.h"
+#include "../lqtutils_lfqueue.h"
+#include "../lqtutils_wsqueue.h"
+#include "../lqtutils_threading.h"
+#include "../lqtutils_executor.h"
+#include "../lqtutils_actor.h"
+#include "../lqtutils_parallel.h"
+#include "../lqtutils_timerwheel.h"
+
+// Counts the allocations made by each thread. This replaces the global
+// allocation functions of the whole binary, so it is kept out of the tests.
+static thread_local qint64 lqt_allocations = 0;
+
+static void* lqt_alloc(std::size_t size)
+{
+    lqt_allocations++;
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+static void* lqt_alloc_aligned(std::size_t size, std::align_val_t align)
+{
+    lqt_allocations++;
+#ifdef Q_OS_WIN
+    void* p = _aligned_malloc(size ? size : 1, std::size_t(align));
+#else
+    void* p = nullptr;
+    if (posix_memalign(&p, qMax(sizeof(void*), std::size_t(align)), size ? size : 1))
+        p = nullptr;
+#endif
+    if (p)
+        return p;
+    throw std::bad_alloc();
+}
+
+static void lqt_free_aligned(void* p) noexcept
+{
+#ifdef Q_OS_WIN
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void* operator new(std::size_t size) { return lqt_alloc(size); }
+void* operator new[](std::size_t size) { return lqt_alloc(size); }
+void* operator new(std::size_t size, std::align_val_t align) { return lqt_alloc_aligned(size, align); }
+void* operator new[](std::size_t size, std::align_val_t align) { return lqt_alloc_aligned(size, align); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { lqt_free_aligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { lqt_free_aligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { lqt_free_aligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { lqt_free_aligned(p); }
+
+static void lqt_busy_wait(qint64 ns)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.nsecsElapsed() < ns) {}
+}
+
+template<typename Q>
+static qint64 lqt_queue_contention(Q& queue, int threads, int count)
+{
+    QList<QThread*> workers;
+    std::atomic<qint64> sum(0);
+    const int perThread = count/threads;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < threads; i++) {
+        workers.append(QThread::create([&queue, perThread] {
+            for (int j = 0; j < perThread; j++)
+                queue.enqueue(j);
+        }));
+        workers.append(QThread::create([&queue, &sum, perThread] {
+            qint64 partial = 0;
+            for (int j = 0; j < perThread; j++)
+                partial += *queue.dequeue();
+            sum += partial;
+        }));
+    }
+    for (QThread* worker : workers)
+        worker->start();
+    for (QThread* worker : workers)
+        worker->wait();
+    qDeleteAll(workers);
+
+    const qint64 expected = qint64(threads)*perThread*(perThread - 1)/2;
+    return sum == expected ? timer.elapsed() : -1;
+}
+
+template<typename Q, typename F>
+static qint64 lqt_queue_fanout(Q& queue, int consumers, int count, F dequeue)
+{
+    QList<QThread*> workers;
+    std::atomic<qint64> sum(0);
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < consumers; i++) {
+        workers.append(QThread::create([&queue, &sum, &dequeue, i] {
+            qint64 partial = 0;
+            while (std::optional<int> item = dequeue(queue, i))
+                partial += *item;
+            sum += partial;
+        }));
+    }
+    for (QThread* worker : workers)
+        worker->start();
+    for (int i = 0; i < count; i++)
+        queue.enqueue(i);
+    while (!queue.isEmpty())
+        QThread::yieldCurrentThread();
+    queue.requestDispose();
+    for (QThread* worker : workers)
+        worker->wait();
+    qDeleteAll(workers);
+
+    return sum == qint64(count)*(count - 1)/2 ? timer.elapsed() : -1;
+}
+
+template<typename WaitPolicy>
+static lqt::LatencyHistogram lqt_handoff_latency(int count)
+{
+    lqt::BlockingQueue<qint64, lqt::RingBuffer<qint64>, WaitPolicy> ping(1);
+    lqt::BlockingQueue<qint64, lqt::RingBuffer<qint64>, WaitPolicy> pong(1);
+    lqt::LatencyHistogram latency;
+    QElapsedTimer clock;
+    clock.start();
+    QScopedPointer<QThread> consumer(QThread::create([&] {
+        while (std::optional<qint64> sent = ping.dequeue()) {
+            latency.add(clock.nsecsElapsed() - *sent);
+            pong.enqueue(0);
+        }
+    }));
+    consumer->start();
+    for (int i = 0; i < count; i++) {
+        ping.enqueue(clock.nsecsElapsed());
+        pong.dequeue();
+    }
+    ping.requestDispose();
+    consumer->wait();
+    return latency;
+}
+
+/**
+ * @brief The LQtUtilsBench class measures allocations and timings. Results
+ * depend on the platform, so they are printed instead of being verified.
+ */
+class LQtUtilsBench : public QObject
+{
+    Q_OBJECT
+private slots:
+    void spscQueue();
+    void mpmcQueue();
+    void workStealingQueue();
+    void handoffLatency();
+    void callableAllocations();
+    void threadDispatch();
+    void executor();
+    void parallelFor();
+    void actors();
+    void batchedDispatch();
+    void timerWheel();
+};
+
+void LQtUtilsBench::spscQueue()
+{
+    const int count = 1E6;
+    lqt::SpscBlockingQueue<int> spsc(1024);
+    lqt::BlockingQueue<int> blocking(1024);
+    auto run = [count] (auto& q) -> qint64 {
+        QElapsedTimer timer;
+        timer.start();
+        QScopedPointer<QThread> producer(QThread::create([&q, count] {
+            for (int i = 0; i < count; i++)
+                q.enqueue(i);
+        }));
+        producer->start();
+        for (int i = 0; i < count; i++) {
+            std::optional<int> v = q.dequeue();
+            if (!v || *v != i)
+                return -1;
+        }
+        producer->wait();
+        return timer.nsecsElapsed()/count;
+    };
+    const qint64 spscNs = run(spsc);
+    const qint64 blockingNs = run(blocking);
+    QVERIFY(spscNs >= 0);
+    QVERIFY(blockingNs >= 0);
+    qDebug() << "SPSC queue:" << spscNs << "ns/item, blocking queue:" << blockingNs << "ns/item";
+}
+
+void LQtUtilsBench::mpmcQueue()
+{
+    const int count = 2E5;
+    for (int threads = 1; threads <= 32; threads *= 2) {
+        lqt::MpmcBlockingQueue<int> mpmc(256);
+        lqt::BlockingQueue<int> blocking(256);
+        const qint64 mpmcTime = lqt_queue_contention(mpmc, threads, count);
+        const qint64 blockingTime = lqt_queue_contention(blocking, threads, count);
+        QVERIFY(mpmcTime >= 0);
+        QVERIFY(blockingTime >= 0);
+        qDebug() << threads << "producers and consumers, MPMC queue:" << mpmcTime
+                 << "ms, blocking queue:" << blockingTime << "ms";
+    }
+}
+
+void LQtUtilsBench::workStealingQueue()
+{
+    const int items = 2E5;
+    for (int consumers : { 2, 4, 8, 16 }) {
+        lqt::WorkStealingQueue<int> sharded(consumers, 256);
+        lqt::BlockingQueue<int> blocking(256);
+        const qint64 shardedTime = lqt_queue_fanout(sharded, consumers, items, [] (lqt::WorkStealingQueue<int>& q, int i) {
+            return q.dequeue(i);
+        });
+        const qint64 blockingTime = lqt_queue_fanout(blocking, consumers, items, [] (lqt::BlockingQueue<int>& q, int) {
+            return q.dequeue();
+        });
+        QVERIFY(shardedTime >= 0);
+        QVERIFY(blockingTime >= 0);
+        qDebug() << consumers << "consumers, work-stealing queue:" << shardedTime
+                 << "ms, blocking queue:" << blockingTime << "ms";
+    }
+}
+
+void LQtUtilsBench::handoffLatency()
+{
+    const int count = 1E4;
+    const lqt::LatencyHistogram block = lqt_handoff_latency<lqt::BlockWaitPolicy>(count);
+    const lqt::LatencyHistogram spin = lqt_handoff_latency<lqt::SpinWaitPolicy<>>(count);
+    const lqt::LatencyHistogram yield = lqt_handoff_latency<lqt::YieldWaitPolicy<>>(count);
+    QVERIFY(block.count() == count);
+    QVERIFY(spin.count() == count);
+    QVERIFY(yield.count() == count);
+    qDebug() << "Handoff latency block p50:" << block.percentile(50) << "ns, p99:" << block.percentile(99) << "ns";
+    qDebug() << "Handoff latency spin p50:" << spin.percentile(50) << "ns, p99:" << spin.percentile(99) << "ns";
+    qDebug() << "Handoff latency yield p50:" << yield.percentile(50) << "ns, p99:" << yield.percentile(99) << "ns";
+}
+
+void LQtUtilsBench::callableAllocations()
+{
+    // A capture of four pointers, as large as the inline buffer of
+    // UniqueFunction and larger than the one of std::function in most
+    // implementations.
+    qint64 sum = 0;
+    qint64 a = 1, b = 2, c = 3;
+    auto large = [&sum, pa = &a, pb = &b, pc = &c] { sum += *pa + *pb + *pc; };
+
+    const int count = 1000;
+    qint64 start = lqt_allocations;
+    for (int i = 0; i < count; i++) {
+        std::function<void()> f(large);
+        f();
+    }
+    const qint64 functionAllocs = lqt_allocations - start;
+    start = lqt_allocations;
+    for (int i = 0; i < count; i++) {
+        lqt::UniqueFunction<void()> f(large);
+        f();
+    }
+    const qint64 uniqueAllocs = lqt_allocations - start;
+
+    start = lqt_allocations;
+    for (int i = 0; i < count; i++)
+        lqt::AutoExec exec { std::function<void()>(large) };
+    const qint64 autoExecBefore = lqt_allocations - start;
+    start = lqt_allocations;
+    for (int i = 0; i < count; i++)
+        lqt::AutoExec exec(large);
+    const qint64 autoExecAfter = lqt_allocations - start;
+
+    start = lqt_allocations;
+    for (int i = 0; i < count; i++)
+        lqt::measure_time(std::function<void()>(large), std::function<void(const qint64&)>([&sum, &a, &b] (qint64) { sum += a + b; }));
+    const qint64 measureBefore = lqt_allocations - start;
+    start = lqt_allocations;
+    for (int i = 0; i < count; i++)
+        lqt::measure_time(large, [&sum, &a, &b] (qint64) { sum += a + b; });
+    const qint64 measureAfter = lqt_allocations - start;
+
+    QThread t;
+    t.start();
+    lqt::run_in_thread_sync(&t, [] {});
+    start = lqt_allocations;
+    for (int i = 0; i < count; i++)
+        lqt::run_in_thread_sync(&t, std::function<void()>(large));
+    const qint64 syncBefore = lqt_allocations - start;
+    start = lqt_allocations;
+    for (int i = 0; i < count; i++)
+        lqt::run_in_thread_sync(&t, large);
+    const qint64 syncAfter = lqt_allocations - start;
+    t.quit();
+    QVERIFY(t.wait(5000));
+
+    qDebug() << "Allocations per call, std::function:" << double(functionAllocs)/count
+             << "UniqueFunction:" << double(uniqueAllocs)/count;
+    qDebug() << "AutoExec with std::function:" << double(autoExecBefore)/count
+             << "with a lambda:" << double(autoExecAfter)/count;
+    qDebug() << "measure_time with std::function:" << double(measureBefore)/count
+             << "with a lambda:" << double(measureAfter)/count;
+    qDebug() << "run_in_thread_sync with std::function:" << double(syncBefore)/count
+             << "with a lambda:" << double(syncAfter)/count;
+}
+
+void LQtUtilsBench::threadDispatch()
+{
+    QThread t;
+    t.start();
+
+    const int count = 1E4;
+    QAtomicInt done(0);
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < count; i++) {
+        QObject* o = new QObject;
+        o->moveToThread(&t);
+        QTimer::singleShot(0, o, [o, &done] {
+            done.fetchAndAddRelaxed(1);
+            o->deleteLater();
+        });
+    }
+    QTRY_COMPARE_WITH_TIMEOUT(done.loadRelaxed(), count, 10000);
+    const qint64 objectTime = timer.nsecsElapsed();
+
+    done.storeRelaxed(0);
+    timer.restart();
+    for (int i = 0; i < count; i++)
+        lqt::run_in_thread(&t, [&done] { done.fetchAndAddRelaxed(1); });
+    QTRY_COMPARE_WITH_TIMEOUT(done.loadRelaxed(), count, 10000);
+    const qint64 dispatcherTime = timer.nsecsElapsed();
+    qDebug() << "Dispatch with a new QObject per call:" << objectTime/count
+             << "ns/call, with the thread dispatcher:" << dispatcherTime/count << "ns/call";
+
+    t.quit();
+    QVERIFY(t.wait(5000));
+}
+
+void LQtUtilsBench::executor()
+{
+    // Tasks posted without a result are compared with QThreadPool::start(),
+    // tasks returning a QFuture with QtConcurrent::run().
+    const int threads = QThread::idealThreadCount();
+    for (qint64 taskNs : { qint64(1000), qint64(10000), qint64(1000000) }) {
+        const int count = taskNs >= 1000000 ? 200 : 20000;
+        lqt::Executor lqtExecutor(threads);
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < count; i++)
+            lqtExecutor.post([taskNs] { lqt_busy_wait(taskNs); });
+        lqtExecutor.waitForDone();
+        const qint64 executorTime = timer.elapsed();
+
+        QThreadPool pool;
+        pool.setMaxThreadCount(threads);
+        timer.restart();
+        for (int i = 0; i < count; i++)
+            pool.start([taskNs] { lqt_busy_wait(taskNs); });
+        pool.waitForDone();
+        const qint64 poolTime = timer.elapsed();
+
+        QList<QFuture<void>> futures;
+        futures.reserve(count);
+        timer.restart();
+        for (int i = 0; i < count; i++)
+            futures.append(lqtExecutor.submit([taskNs] { lqt_busy_wait(taskNs); }));
+        for (QFuture<void>& future : futures)
+            future.waitForFinished();
+        const qint64 submitTime = timer.elapsed();
+
+        futures.clear();
+        timer.restart();
+        for (int i = 0; i < count; i++)
+            futures.append(QtConcurrent::run(&pool, [taskNs] { lqt_busy_wait(taskNs); }));
+        for (QFuture<void>& future : futures)
+            future.waitForFinished();
+        const qint64 concurrentTime = timer.elapsed();
+
+        qDebug() << count << "tasks of" << taskNs/1000 << "us, executor:" << executorTime
+                 << "ms, QThreadPool:" << poolTime << "ms";
+        qDebug() << count << "tasks of" << taskNs/1000 << "us, executor with futures:" << submitTime
+                 << "ms, QtConcurrent::run:" << concurrentTime << "ms";
+    }
+}
+
+void LQtUtilsBench::parallelFor()
+{
+    for (int threads : { 1, 2, 4, QThread::idealThreadCount() }) {
+        lqt::Executor scaling(threads);
+        lqt::ParallelOptions scalingOptions;
+        scalingOptions.executor = &scaling;
+        QElapsedTimer timer;
+        timer.start();
+        QVERIFY(lqt::parallel_for(0, 2000, [] (qsizetype) { lqt_busy_wait(10000); }, scalingOptions));
+        qDebug() << "parallel_for with" << threads << "threads:" << timer.elapsed() << "ms";
+    }
+}
+
+void LQtUtilsBench::actors()
+{
+    lqt::Executor executor(2);
+    std::atomic<qint64> received(0);
+    std::vector<std::unique_ptr<lqt::Actor<QString>>> actors;
+    const qint64 allocs = lqt_allocations;
+    for (int i = 0; i < 1E4; i++) {
+        actors.emplace_back(new lqt::Actor<QString>([&received] (QString& s) {
+            received += s.size();
+        }, 16, &executor));
+    }
+    qDebug() << "Allocations per actor:" << double(lqt_allocations - allocs)/actors.size()
+             << "size:" << sizeof(lqt::Actor<QString>) << "bytes";
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < 10; i++) {
+        for (std::unique_ptr<lqt::Actor<QString>>& actor : actors)
+            actor->tell(QStringLiteral("ab"));
+    }
+    for (std::unique_ptr<lqt::Actor<QString>>& actor : actors)
+        actor->stop();
+    qDebug() << "Delivered" << actors.size()*10 << "messages in" << timer.elapsed() << "ms";
+    QCOMPARE(received.load(), qint64(actors.size())*10*2);
+}
+
+void LQtUtilsBench::batchedDispatch()
+{
+    QThread t;
+    t.start();
+
+    const int count = 1E4;
+    QAtomicInt done(0);
+    lqt::DispatchBatcher batcher(64);
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < count; i++)
+        batcher.post(&t, [&done] { done.fetchAndAddRelaxed(1); });
+    QTRY_COMPARE_WITH_TIMEOUT(done.loadRelaxed(), count, 10000);
+    const qint64 batcherTime = timer.nsecsElapsed();
+
+    done.storeRelaxed(0);
+    timer.restart();
+    for (int i = 0; i < count; i++)
+        lqt::run_in_thread(&t, [&done] { done.fetchAndAddRelaxed(1); });
+    QTRY_COMPARE_WITH_TIMEOUT(done.loadRelaxed(), count, 10000);
+    const qint64 dispatcherTime = timer.nsecsElapsed();
+    qDebug() << "Batched dispatch:" << batcherTime/count << "ns/call in" << batcher.batchCount()
+             << "events, one event per call:" << dispatcherTime/count << "ns/call";
+
+    t.quit();
+    QVERIFY(t.wait(5000));
+}
+
+void LQtUtilsBench::timerWheel()
+{
+    lqt::TimerWheel wheel;
+    const int count = 20000;
+    int fired = 0;
+    QList<lqt::TimerWheel::Handle> handles;
+    handles.reserve(count);
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < count; i++)
+        handles.append(wheel.schedule(i%500, [&fired] { fired++; }));
+    for (int i = 0; i < count; i += 4)
+        wheel.cancel(handles[i]);
+    const qint64 scheduleTime = timer.nsecsElapsed();
+    qDebug() << "Scheduled and canceled" << count << "callbacks in" << scheduleTime/1000 << "us";
+    QTRY_COMPARE_WITH_TIMEOUT(fired, count - count/4, 5000);
+}
+
+QTEST_GUILESS_MAIN(LQtUtilsBench)
+
+#include "bench_lqtutils.moc"
@@ -35,6 +35,11 @@
 #include <QTemporaryFile>
 #include <QElapsedTimer>
 #include <QByteArray>
+#include <QSignalSpy>
+
+#include <array>
+#include <vector>
+#include <memory>
 
 #include "../lqtutils_prop.h"
 #include "../lqtutils_string.h"
@@ -46,6 +51,18 @@
 #include "../lqtutils_time.h"
 #include "../lqtutils_ui.h"
 #include "../lqtutils_bqueue.h"
+#include "../lqtutils_lfqueue.h"
+#include "../lqtutils_qmonitor.h"
+#include "../lqtutils_qconsumer.h"
+#include "../lqtutils_spillqueue.h"
+#include "../lqtutils_wsqueue.h"
+#include "../lqtutils_executor.h"
+#include "../lqtutils_actor.h"
+#include "../lqtutils_pipeline.h"
+#include "../lqtutils_timerwheel.h"
+#include "../lqtutils_ratelimit.h"
+#include "../lqtutils_function.h"
+#include "../lqtutils_parallel.h"
 #include "../lqtutils_net.h"
 #include "../lqtutils_data.h"
 #include "../lqtutils_logging.h"
@@ -164,6 +181,12 @@ L_RW_PROP_REF(QStringList, myListRef, setMyListRef, QStringList() << "hello")
 L_RO_PROP(QStringList, myList, setMyList, QStringList() << "hello")
 L_END_CLASS
 
+L_BEGIN_CLASS(LRateLimitTest)
+L_RW_PROP_THROTTLED(int, position, 20, 0)
+L_RO_PROP_DEBOUNCED(QString, query, 30)
+L_RW_PROP_COALESCED(int, counter, 0)
+L_END_CLASS
+
 L_DECLARE_SETTINGS(LSettingsTest, new QSettings("settings.ini", QSettings::IniFormat))
 L_DEFINE_VALUE(QString, string1, QString("string1"))
 L_DEFINE_VALUE(QSize, size, QSize(100, 100))
@@ -230,6 +253,32 @@ private slots:
     void test_case36();
     void test_case37();
     void test_case38();
+    void test_case39();
+    void test_case40();
+    void test_case41();
+    void test_case42();
+    void test_case43();
+    void test_case44();
+    void test_case45();
+    void test_case46();
+    void test_case47();
+    void test_case48();
+    void test_case49();
+    void test_case50();
+    void test_case51();
+    void test_case52();
+    void test_case53();
+    void test_case54();
+    void test_case55();
+    void test_case56();
+    void test_case57();
+    void test_case58();
+    void test_case59();
+    void test_case60();
+    void test_case61();
+    void test_case62();
+    void test_case63();
+    void test_case64();
 };
 
 LQtUtilsTest::LQtUtilsTest()
@@ -1116,6 +1165,1378 @@ void LQtUtilsTest::test_case38()
     qDebug() << "Qt property built using lqt macro:" << timer.elapsed();
 }
 
+void LQtUtilsTest::test_case39()
+{
+    lqt::SpscBlockingQueue<int> queue(5);
+    QCOMPARE(queue.capacity(), 8);
+    for (int i = 0; i < queue.capacity(); i++)
+        QVERIFY(queue.enqueue(i, 0));
+    QVERIFY(!queue.enqueue(8, 5));
+    QCOMPARE(queue.size(), 8);
+    QCOMPARE(*queue.peek(), 0);
+    for (int i = 0; i < queue.capacity(); i++)
+        QCOMPARE(*queue.dequeue(), i);
+    QVERIFY(queue.dequeue(5) == std::nullopt);
+    QVERIFY(queue.isEmpty());
+
+    lqt::SpscBlockingQueue<std::unique_ptr<int>> ptrQueue(2);
+    QVERIFY(ptrQueue.enqueue(std::make_unique<int>(10)));
+    QCOMPARE(**ptrQueue.dequeue(), 10);
+
+    const int count = 1E4;
+    lqt::SpscBlockingQueue<int> spsc(64);
+    QScopedPointer<QThread> producer(QThread::create([&spsc, count] {
+        for (int i = 0; i < count; i++)
+            spsc.enqueue(i);
+    }));
+    producer->start();
+    bool ordered = true;
+    for (int i = 0; i < count; i++) {
+        std::optional<int> v = spsc.dequeue();
+        ordered = ordered && v && *v == i;
+    }
+    QVERIFY(producer->wait(5000));
+    QVERIFY(ordered);
+
+    // QTest macros are only used by the test thread.
+    std::optional<int> disposed = 0;
+    QScopedPointer<QThread> consumer(QThread::create([&spsc, &disposed] {
+        disposed = spsc.dequeue();
+    }));
+    consumer->start();
+    QThread::msleep(50);
+    spsc.requestDispose();
+    QVERIFY(consumer->wait(5000));
+    QVERIFY(disposed == std::nullopt);
+    QVERIFY(!spsc.enqueue(0));
+}
+
+void LQtUtilsTest::test_case40()
+{
+    lqt::MpmcBlockingQueue<int> queue(3);
+    QCOMPARE(queue.capacity(), 4);
+    for (int i = 0; i < queue.capacity(); i++)
+        QVERIFY(queue.enqueue(i, 0));
+    QVERIFY(!queue.enqueue(4, 5));
+    for (int i = 0; i < queue.capacity(); i++)
+        QCOMPARE(*queue.dequeue(), i);
+    QVERIFY(queue.dequeue(5) == std::nullopt);
+
+    QList<QThread*> consumers;
+    std::atomic<int> disposed(0);
+    for (int i = 0; i < 4; i++)
+        consumers.append(QThread::create([&queue, &disposed] {
+            if (queue.dequeue() == std::nullopt)
+                disposed++;
+        }));
+    for (QThread* consumer : consumers)
+        consumer->start();
+    QThread::msleep(50);
+    queue.requestDispose();
+    for (QThread* consumer : consumers)
+        QVERIFY(consumer->wait(5000));
+    qDeleteAll(consumers);
+    QCOMPARE(disposed.load(), 4);
+}
+
+void LQtUtilsTest::test_case41()
+{
+    lqt::BlockingQueue<int> queue(5);
+    QCOMPARE(queue.enqueueMany(QList<int>()), 0);
+    QCOMPARE(queue.enqueueMany(QList<int> { 0, 1, 2 }), 3);
+    QCOMPARE(queue.enqueueMany(QList<int> { 3, 4, 5, 6 }), 2);
+    QCOMPARE(queue.size(), 5);
+    QCOMPARE(queue.enqueueMany(QList<int> { 5 }, 5), 0);
+
+    QCOMPARE(queue.dequeueUpTo(2), QList<int>({ 0, 1 }));
+    QCOMPARE(queue.dequeueUpTo(10), QList<int>({ 2, 3, 4 }));
+    QVERIFY(queue.dequeueUpTo(10, 0).isEmpty());
+    QVERIFY(queue.dequeueUpTo(10, 5).isEmpty());
+
+    const int count = 1E5;
+    QScopedPointer<QThread> producer(QThread::create([&queue, count] {
+        int next = 0;
+        while (next < count) {
+            QList<int> batch;
+            for (int i = next; i < qMin(next + 3, count); i++)
+                batch.append(i);
+            next += queue.enqueueMany(batch);
+        }
+    }));
+    producer->start();
+    int expected = 0;
+    while (expected < count) {
+        const QList<int> items = queue.dequeueUpTo(4);
+        QVERIFY(!items.isEmpty());
+        for (int item : items)
+            QCOMPARE(item, expected++);
+    }
+    QVERIFY(producer->wait(5000));
+
+    queue.requestDispose();
+    QCOMPARE(queue.enqueueMany(QList<int> { 1 }), 0);
+    QVERIFY(queue.dequeueUpTo(1).isEmpty());
+}
+
+void LQtUtilsTest::test_case42()
+{
+    lqt::BlockingQueue<std::unique_ptr<QString>> queue(3);
+    QVERIFY(queue.enqueue(std::make_unique<QString>(QSL("first"))));
+    QVERIFY(queue.emplace(new QString(QSL("second"))));
+    std::vector<std::unique_ptr<QString>> batch;
+    batch.push_back(std::make_unique<QString>(QSL("third")));
+    batch.push_back(std::make_unique<QString>(QSL("fourth")));
+    QCOMPARE(queue.enqueueMany(std::move(batch)), 1);
+    QVERIFY(!queue.emplaceWithTimeout(5, new QString));
+    QCOMPARE(**queue.dequeue(), QSL("first"));
+    QCOMPARE(**queue.dequeue(), QSL("second"));
+    QCOMPARE(**queue.dequeue(), QSL("third"));
+    QVERIFY(queue.dequeue(0) == std::nullopt);
+
+    lqt::BlockingQueue<QString> strings(2);
+    for (int i = 0; i < 1E4; i++) {
+        QVERIFY(strings.enqueue(QString::number(i)));
+        QVERIFY(strings.emplace(QSL("next")));
+        QCOMPARE(*strings.peek(), QString::number(i));
+        QCOMPARE(*strings.dequeue(), QString::number(i));
+        QCOMPARE(*strings.dequeue(), QSL("next"));
+    }
+    QVERIFY(strings.isEmpty());
+}
+
+struct LQTTestCommand
+{
+    int priority;
+    int id;
+    bool operator<(const LQTTestCommand& other) const { return priority < other.priority; }
+};
+
+void LQtUtilsTest::test_case43()
+{
+    lqt::PriorityBlockingQueue<LQTTestCommand> queue(6);
+    QVERIFY(queue.enqueue({ 0, 1 }));
+    QVERIFY(queue.enqueue({ 0, 2 }));
+    QVERIFY(queue.enqueue({ 5, 3 }));
+    QVERIFY(queue.enqueue({ 0, 4 }));
+    QVERIFY(queue.enqueue({ 5, 5 }));
+    QVERIFY(queue.emplace(LQTTestCommand { 1, 6 }));
+    QVERIFY(!queue.enqueue({ 9, 7 }, 5));
+    QCOMPARE(queue.peek()->id, 3);
+    for (int id : { 3, 5, 6, 1, 2, 4 })
+        QCOMPARE(queue.dequeue()->id, id);
+    QVERIFY(queue.dequeue(0) == std::nullopt);
+
+    lqt::PriorityBlockingQueue<int, std::greater<int>> minQueue(10);
+    QCOMPARE(minQueue.enqueueMany(QList<int> { 5, 3, 8, 1 }), 4);
+    QCOMPARE(minQueue.dequeueUpTo(2), QList<int>({ 1, 3 }));
+    QCOMPARE(minQueue.dequeueUpTo(10), QList<int>({ 5, 8 }));
+
+    QScopedPointer<QThread> consumer(QThread::create([&minQueue] {
+        QVERIFY(minQueue.dequeue() == std::nullopt);
+    }));
+    consumer->start();
+    QThread::msleep(50);
+    minQueue.requestDispose();
+    QVERIFY(consumer->wait(5000));
+}
+
+void LQtUtilsTest::test_case44()
+{
+    lqt::BlockingQueue<int> queue1(4);
+    lqt::BlockingQueue<QString> queue2(4);
+    lqt::PriorityBlockingQueue<int> queue3(4);
+
+    lqt::QueueSelector selector;
+    QCOMPARE(selector.add(&queue1), 0);
+    QCOMPARE(selector.add(&queue2), 1);
+    QCOMPARE(selector.add(&queue3), 2);
+    QCOMPARE(selector.wait(5), -1);
+
+    QScopedPointer<QThread> producer(QThread::create([&queue3] {
+        QThread::msleep(50);
+        queue3.enqueue(7);
+    }));
+    producer->start();
+    QCOMPARE(selector.wait(), 2);
+    QCOMPARE(*queue3.dequeue(0), 7);
+    QVERIFY(producer->wait(5000));
+
+    queue1.enqueue(1);
+    queue2.enqueue(QSL("2"));
+    QCOMPARE(selector.wait(), 0);
+    QCOMPARE(*queue1.dequeue(0), 1);
+    QCOMPARE(selector.wait(), 1);
+    QCOMPARE(*queue2.dequeue(0), QSL("2"));
+
+    producer.reset(QThread::create([&queue2] {
+        QThread::msleep(50);
+        queue2.requestDispose();
+    }));
+    producer->start();
+    QCOMPARE(selector.wait(), 1);
+    QVERIFY(queue2.isDisposed());
+    QVERIFY(producer->wait(5000));
+}
+
+void LQtUtilsTest::test_case45()
+{
+    lqt::BlockingQueue<int> queue(4, QSL("monitored"));
+    lqt::QueueMonitor monitor(&queue, 10);
+    QVERIFY(queue.statsEnabled());
+    QCOMPARE(monitor.name(), QSL("monitored"));
+    QCOMPARE(monitor.capacity(), 4);
+
+    QVERIFY(queue.enqueueMany(QList<int> { 0, 1, 2 }) == 3);
+    QThread::msleep(20);
+    QVERIFY(queue.dequeue());
+    QCOMPARE(queue.dequeueUpTo(2).size(), 2);
+    QCOMPARE(queue.enqueueMany(QList<int> { 0, 1, 2, 3 }), 4);
+    QVERIFY(!queue.enqueue(4, 10));
+    QVERIFY(queue.enqueueDropFirst(5, 10));
+
+    const lqt::QueueStats stats = queue.stats();
+    QVERIFY(stats.enqueued == 8);
+    QVERIFY(stats.dequeued == 3);
+    QVERIFY(stats.dropped == 1);
+    QCOMPARE(stats.highWaterMark, 4);
+    QVERIFY(stats.producerBlockedNs >= 15*1000*1000);
+    QVERIFY(stats.residenceP50Ns >= 15*1000*1000);
+    QVERIFY(stats.residenceMaxNs >= stats.residenceP99Ns);
+
+    QSignalSpy spy(&monitor, &lqt::QueueMonitor::enqueuedChanged);
+    QVERIFY(spy.wait(1000));
+    QVERIFY(monitor.enqueued() == 8);
+    QVERIFY(monitor.dropped() == 1);
+    QCOMPARE(monitor.size(), 4);
+    QVERIFY(monitor.residenceP50Ms() >= 15);
+
+    queue.resetStats();
+    QVERIFY(queue.stats().enqueued == 0);
+    QCOMPARE(queue.stats().highWaterMark, 4);
+}
+
+void LQtUtilsTest::test_case46()
+{
+    lqt::BlockingQueue<int> queue(3);
+    for (int i = 0; i < 10; i++)
+        QVERIFY(queue.enqueueOverwrite(i));
+    QCOMPARE(queue.size(), 3);
+    QVERIFY(queue.stats().dropped == 7);
+    QCOMPARE(*queue.dequeue(), 7);
+    QCOMPARE(*queue.dequeue(), 8);
+    QCOMPARE(*queue.dequeue(), 9);
+
+    lqt::BlockingQueue<std::unique_ptr<int>> ptrQueue(1);
+    QVERIFY(ptrQueue.enqueueOverwrite(std::make_unique<int>(1)));
+    QVERIFY(ptrQueue.enqueueOverwrite(std::make_unique<int>(2)));
+    QCOMPARE(**ptrQueue.dequeue(), 2);
+
+    // Producers are never slowed down by a slow consumer.
+    lqt::BlockingQueue<int> slowQueue(16);
+    QScopedPointer<QThread> consumer(QThread::create([&slowQueue] {
+        while (slowQueue.dequeue())
+            QThread::msleep(1);
+    }));
+    consumer->start();
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < 100000; i++)
+        slowQueue.enqueueOverwrite(i);
+    QVERIFY(timer.elapsed() < 5000);
+    QVERIFY(slowQueue.stats().dropped > 0);
+    slowQueue.requestDispose();
+    QVERIFY(!slowQueue.enqueueOverwrite(0));
+    QVERIFY(consumer->wait(5000));
+}
+
+void LQtUtilsTest::test_case47()
+{
+    lqt::ByteBudgetBlockingQueue<QByteArray> queue(100, [] (const QByteArray& data) {
+        return qint64(data.size());
+    });
+    QVERIFY(queue.byteBudget() == 100);
+    QVERIFY(queue.enqueue(QByteArray(60, 'a'), 0));
+    QVERIFY(!queue.enqueue(QByteArray(50, 'b'), 0));
+    QVERIFY(queue.enqueue(QByteArray(40, 'c'), 0));
+    QVERIFY(queue.bytesInFlight() == 100);
+    QCOMPARE(queue.size(), 2);
+
+    QScopedPointer<QThread> producer(QThread::create([&queue] {
+        queue.enqueue(QByteArray(50, 'd'));
+    }));
+    producer->start();
+    QThread::msleep(20);
+    QCOMPARE(queue.size(), 2);
+    QCOMPARE(queue.dequeue()->size(), 60);
+    QVERIFY(producer->wait(5000));
+    QVERIFY(queue.bytesInFlight() == 90);
+
+    QCOMPARE(queue.dequeueUpTo(10).size(), 2);
+    QVERIFY(queue.bytesInFlight() == 0);
+
+    // A single oversized element is accepted when the queue is empty.
+    QVERIFY(queue.enqueue(QByteArray(1000, 'x'), 0));
+    QVERIFY(!queue.enqueue(QByteArray(1, 'y'), 0));
+    QVERIFY(queue.bytesInFlight() == 1000);
+    QCOMPARE(queue.peek()->size(), 1000);
+
+    // Overwriting drops the oldest elements until the new one fits.
+    QVERIFY(queue.enqueueOverwrite(QByteArray(30, 'o')));
+    QVERIFY(queue.bytesInFlight() == 30);
+    QVERIFY(queue.enqueue(QByteArray(50, 'p'), 0));
+    QVERIFY(queue.enqueueOverwrite(QByteArray(40, 'q')));
+    QCOMPARE(queue.size(), 2);
+    QVERIFY(queue.bytesInFlight() == 90);
+    QVERIFY(queue.stats().dropped == 2);
+    QVERIFY(queue.stats().enqueued == 7);
+
+    queue.requestDispose();
+    QVERIFY(!queue.dequeue());
+    QVERIFY(!queue.enqueue(QByteArray(1, 'z')));
+}
+
+struct LQTTestRecord
+{
+    int value = 0;
+};
+
+QDataStream& operator<<(QDataStream& out, const LQTTestRecord& r)
+{ return out << r.value; }
+
+QDataStream& operator>>(QDataStream& in, LQTTestRecord& r)
+{
+    in >> r.value;
+    // Negative values simulate records that cannot be read back.
+    if (r.value < 0)
+        in.setStatus(QDataStream::ReadCorruptData);
+    return in;
+}
+
+void LQtUtilsTest::test_case48()
+{
+    lqt::SpillBlockingQueue<int> queue(4);
+    queue.setSegmentSize(64);
+    for (int i = 0; i < 1000; i++)
+        QVERIFY(queue.enqueue(i, 0));
+    QCOMPARE(queue.size(), 1000);
+    QCOMPARE(queue.memorySize(), 4);
+    QCOMPARE(queue.spilledCount(), 996);
+    QVERIFY(queue.spilledBytes() > 0);
+
+    for (int i = 0; i < 500; i++)
+        QCOMPARE(*queue.dequeue(0), i);
+    for (int i = 1000; i < 1200; i++)
+        QVERIFY(queue.enqueue(i, 0));
+    for (int i = 500; i < 1200; i++)
+        QCOMPARE(*queue.dequeue(0), i);
+    QVERIFY(queue.isEmpty());
+    QVERIFY(queue.spilledBytes() == 0);
+    QCOMPARE(queue.capacity(), 4);
+    QVERIFY(queue.stats().enqueued == 1200);
+    QVERIFY(queue.stats().dequeued == 1200);
+    QCOMPARE(queue.stats().highWaterMark, 1000);
+
+    // When the spill budget is exhausted, producers wait.
+    lqt::SpillBlockingQueue<QByteArray> budgetQueue(2, QDir::tempPath(), 64);
+    QVERIFY(budgetQueue.enqueue(QByteArray(8, 'a'), 0));
+    QVERIFY(budgetQueue.enqueue(QByteArray(8, 'b'), 0));
+    QVERIFY(budgetQueue.enqueue(QByteArray(32, 'c'), 0));
+    QVERIFY(!budgetQueue.enqueue(QByteArray(32, 'd'), 0));
+    QScopedPointer<QThread> producer(QThread::create([&budgetQueue] {
+        budgetQueue.enqueue(QByteArray(32, 'd'));
+    }));
+    producer->start();
+    QThread::msleep(20);
+    QCOMPARE(*budgetQueue.dequeue(), QByteArray(8, 'a'));
+    QVERIFY(producer->wait(5000));
+    QCOMPARE(*budgetQueue.dequeue(), QByteArray(8, 'b'));
+    QCOMPARE(*budgetQueue.dequeue(), QByteArray(32, 'c'));
+    QCOMPARE(*budgetQueue.dequeue(), QByteArray(32, 'd'));
+
+    QScopedPointer<QThread> consumer(QThread::create([&budgetQueue] {
+        for (int i = 0; i < 10000; i++)
+            if (budgetQueue.dequeue()->size() != i%7)
+                return;
+        budgetQueue.requestDispose();
+    }));
+    consumer->start();
+    for (int i = 0; i < 10000; i++)
+        budgetQueue.enqueue(QByteArray(i%7, 'e'));
+    QVERIFY(consumer->wait(10000));
+    QVERIFY(budgetQueue.isDisposed());
+    QVERIFY(!budgetQueue.dequeue());
+
+    // Records that cannot be read back are counted as dropped.
+    lqt::SpillBlockingQueue<LQTTestRecord> records(2);
+    for (int i : { 0, 1, -2, -3, 4, -5, 6 })
+        QVERIFY(records.enqueue(LQTTestRecord { i }, 0));
+    QCOMPARE(records.dequeue()->value, 0);
+    QVERIFY(records.stats().dropped == 2);
+    QCOMPARE(records.size(), 4);
+    const QList<LQTTestRecord> read = records.dequeueUpTo(10);
+    QCOMPARE(read.size(), 3);
+    QCOMPARE(read[1].value, 4);
+    QCOMPARE(read[2].value, 6);
+    QVERIFY(records.stats().dropped == 3);
+    QVERIFY(records.isEmpty());
+}
+
+void LQtUtilsTest::test_case49()
+{
+    lqt::CoalescingBlockingQueue<QString, int> queue(2);
+    QVERIFY(queue.enqueue(QSL("a"), 1, 0));
+    QVERIFY(queue.enqueue(QSL("b"), 2, 0));
+    QVERIFY(queue.enqueue(QSL("a"), 3, 0));
+    QVERIFY(!queue.enqueue(QSL("c"), 4, 0));
+    QCOMPARE(queue.size(), 2);
+    QVERIFY(queue.contains(QSL("a")));
+    QVERIFY(queue.coalescedCount() == 1);
+
+    std::optional<std::pair<QString, int>> update = queue.dequeue();
+    QVERIFY(update);
+    QCOMPARE(update->first, QSL("a"));
+    QCOMPARE(update->second, 3);
+    QVERIFY(queue.enqueue(QSL("c"), 4, 0));
+
+    const QList<std::pair<QString, int>> updates = queue.dequeueUpTo(10);
+    QCOMPARE(updates.size(), 2);
+    QCOMPARE(updates[0].first, QSL("b"));
+    QCOMPARE(updates[1].second, 4);
+    QVERIFY(!queue.dequeue(0));
+
+    // Replacements are counted as enqueued, but are dequeued once.
+    QVERIFY(queue.stats().enqueued == 4);
+    QVERIFY(queue.stats().dequeued == 3);
+    QVERIFY(queue.enqueue(QSL("d"), 5, 0));
+    QVERIFY(queue.enqueue(QSL("e"), 6, 0));
+    QVERIFY(queue.enqueueOverwrite(std::make_pair(QSL("f"), 7)));
+    QVERIFY(!queue.contains(QSL("d")));
+    QVERIFY(queue.stats().dropped == 1);
+    QCOMPARE(queue.dequeueUpTo(10).size(), 2);
+
+    // A burst of updates for few keys results in few dequeues.
+    lqt::CoalescingBlockingQueue<int, int> burstQueue(16);
+    for (int i = 0; i < 10000; i++)
+        QVERIFY(burstQueue.enqueue(i%8, i, 0));
+    QCOMPARE(burstQueue.size(), 8);
+    for (int i = 0; i < 8; i++)
+        QCOMPARE(burstQueue.dequeue()->second, 10000 - 8 + i);
+
+    QScopedPointer<QThread> consumer(QThread::create([&burstQueue] {
+        QThread::msleep(50);
+        burstQueue.requestDispose();
+    }));
+    consumer->start();
+    QVERIFY(!burstQueue.dequeue());
+    QVERIFY(!burstQueue.enqueue(0, 0));
+    QVERIFY(consumer->wait(5000));
+}
+
+void LQtUtilsTest::test_case50()
+{
+    lqt::BlockingQueue<int> queue(1000);
+    QVERIFY(queue.enqueue(-1));
+
+    int count = 0;
+    qint64 sum = 0;
+    int maxBatch = 0;
+    const QThread* mainThread = QThread::currentThread();
+    bool sameThread = true;
+    lqt::QueueConsumer consumer(&queue, [&] (QList<int> batch) {
+        sameThread = sameThread && QThread::currentThread() == mainThread;
+        maxBatch = qMax(maxBatch, int(batch.size()));
+        for (int i : batch) {
+            if (i < 0)
+                continue;
+            count++;
+            sum += i;
+        }
+    }, 8);
+    QCOMPARE(consumer.batchSize(), 8);
+    QSignalSpy spy(&consumer, &lqt::QueueConsumer::finished);
+
+    QScopedPointer<QThread> producer(QThread::create([&queue] {
+        for (int i = 0; i < 100000; i++)
+            queue.enqueue(i);
+    }));
+    producer->start();
+    QTRY_COMPARE_WITH_TIMEOUT(count, 100000, 10000);
+    QVERIFY(producer->wait(5000));
+    QVERIFY(sum == qint64(100000)*99999/2);
+    QVERIFY(maxBatch <= 8);
+    QVERIFY(sameThread);
+    QVERIFY(queue.isEmpty());
+
+    queue.requestDispose();
+    QVERIFY(spy.wait(1000));
+    QCOMPARE(spy.count(), 1);
+}
+
+void LQtUtilsTest::test_case51()
+{
+    lqt::WorkStealingQueue<int> queue(4, 8);
+    QCOMPARE(queue.shardCount(), 4);
+    for (int i = 0; i < 8; i++)
+        QVERIFY(queue.enqueueTo(0, i, 0));
+    QVERIFY(!queue.enqueue(8, 5));
+    QCOMPARE(queue.size(), 8);
+
+    // The owner takes from the front, others steal from the back.
+    QCOMPARE(*queue.dequeue(0), 0);
+    QCOMPARE(*queue.dequeue(1), 7);
+    QVERIFY(queue.stolenCount() == 1);
+    QVERIFY(queue.enqueue(8, 0));
+    int count = 0;
+    while (queue.tryDequeue(2))
+        count++;
+    QCOMPARE(count, 7);
+    QVERIFY(queue.isEmpty());
+    QVERIFY(!queue.dequeue(3, 5));
+
+    lqt::WorkStealingQueue<std::unique_ptr<int>> ptrQueue(2, 2);
+    QVERIFY(ptrQueue.enqueue(std::make_unique<int>(3)));
+    QCOMPARE(**ptrQueue.dequeue(1), 3);
+
+    QScopedPointer<QThread> disposer(QThread::create([&ptrQueue] {
+        QThread::msleep(50);
+        ptrQueue.requestDispose();
+    }));
+    disposer->start();
+    QVERIFY(!ptrQueue.dequeue(0));
+    QVERIFY(disposer->wait(5000));
+
+    // Each element is taken exactly once, either by the owner or by a thief.
+    const int items = 1E4;
+    lqt::WorkStealingQueue<int> sharded(4, 64);
+    std::atomic<qint64> sum(0);
+    QList<QThread*> consumers;
+    for (int i = 0; i < sharded.shardCount(); i++) {
+        consumers.append(QThread::create([&sharded, &sum, i] {
+            while (std::optional<int> item = sharded.dequeue(i))
+                sum += *item;
+        }));
+    }
+    for (QThread* consumer : consumers)
+        consumer->start();
+    for (int i = 0; i < items; i++)
+        QVERIFY(sharded.enqueue(i));
+    while (!sharded.isEmpty())
+        QThread::yieldCurrentThread();
+    sharded.requestDispose();
+    for (QThread* consumer : consumers)
+        QVERIFY(consumer->wait(5000));
+    qDeleteAll(consumers);
+    QVERIFY(sum == qint64(items)*(items - 1)/2);
+}
+
+template<typename WaitPolicy>
+static void lqt_test_wait_policy()
+{
+    lqt::BlockingQueue<int, lqt::RingBuffer<int>, WaitPolicy> queue(2);
+    QVERIFY(queue.enqueue(1, 0));
+    QVERIFY(queue.enqueue(2, 0));
+    QVERIFY(!queue.enqueue(3, 5));
+    QCOMPARE(*queue.dequeue(), 1);
+    QCOMPARE(*queue.dequeue(), 2);
+    QVERIFY(!queue.dequeue(5));
+
+    const int count = 1000;
+    QScopedPointer<QThread> producer(QThread::create([&queue, count] {
+        for (int i = 0; i < count; i++)
+            queue.enqueue(i);
+    }));
+    producer->start();
+    bool ordered = true;
+    for (int i = 0; i < count; i++) {
+        std::optional<int> v = queue.dequeue();
+        ordered = ordered && v && *v == i;
+    }
+    QVERIFY(producer->wait(5000));
+    QVERIFY(ordered);
+
+    QScopedPointer<QThread> disposer(QThread::create([&queue] {
+        QThread::msleep(50);
+        queue.requestDispose();
+    }));
+    disposer->start();
+    QVERIFY(!queue.dequeue());
+    QVERIFY(disposer->wait(5000));
+}
+
+void LQtUtilsTest::test_case52()
+{
+    lqt_test_wait_policy<lqt::BlockWaitPolicy>();
+    lqt_test_wait_policy<lqt::SpinWaitPolicy<>>();
+    lqt_test_wait_policy<lqt::YieldWaitPolicy<>>();
+
+    lqt::PriorityBlockingQueue<int, std::less<int>, lqt::YieldWaitPolicy<>> priorityQueue(4);
+    QVERIFY(priorityQueue.enqueue(1));
+    QVERIFY(priorityQueue.enqueue(3));
+    QCOMPARE(*priorityQueue.dequeue(), 3);
+    QCOMPARE(*priorityQueue.dequeue(), 1);
+}
+
+void LQtUtilsTest::test_case53()
+{
+    QThread t;
+    t.start();
+
+    QSemaphore sem;
+    std::unique_ptr<int> value = std::make_unique<int>(5);
+    int result = 0;
+    lqt::ThreadDispatcher::post(&t, [value = std::move(value), &result, &sem, &t] {
+        if (QThread::currentThread() == &t)
+            result = *value;
+        sem.release();
+    });
+    QVERIFY(sem.tryAcquire(1, 5000));
+    QCOMPARE(result, 5);
+
+    // The dispatcher is released when the thread finishes and recreated
+    // when it starts again.
+    t.quit();
+    QVERIFY(t.wait(5000));
+    t.start();
+    lqt::run_in_thread_sync(&t, [&t, &result] {
+        result = QThread::currentThread() == &t ? 6 : 0;
+    });
+    QCOMPARE(result, 6);
+
+    const int count = 1E4;
+    QAtomicInt done(0);
+    for (int i = 0; i < count; i++)
+        lqt::run_in_thread(&t, [&done] { done.fetchAndAddRelaxed(1); });
+    QTRY_COMPARE_WITH_TIMEOUT(done.loadRelaxed(), count, 10000);
+
+    t.quit();
+    QVERIFY(t.wait(5000));
+}
+
+void LQtUtilsTest::test_case54()
+{
+    QThread t;
+    t.start();
+
+    QFuture<int> future = lqt::run_in_thread_async(&t, [&t] {
+        return QThread::currentThread() == &t ? 21 : 0;
+    });
+    QObject context;
+    bool mainThread = false;
+    QFuture<int> doubled = lqt::then(future, &context, [&mainThread] (int value) {
+        mainThread = QThread::currentThread() == qApp->thread();
+        return value*2;
+    });
+    QFuture<void> done = lqt::then(doubled, &context, [] (int) {});
+    QTRY_VERIFY(done.isFinished());
+    QCOMPARE(future.result(), 21);
+    QCOMPARE(doubled.result(), 42);
+    QVERIFY(mainThread);
+    QVERIFY(!done.isCanceled());
+
+    // Requests are issued concurrently and collected later.
+    QList<QFuture<int>> futures;
+    for (int i = 0; i < 100; i++)
+        futures.append(lqt::run_in_thread_async(&t, [i] { return i; }));
+    int sum = 0;
+    for (QFuture<int>& f : futures) {
+        f.waitForFinished();
+        sum += f.result();
+    }
+    QCOMPARE(sum, 4950);
+
+    int calls = 0;
+    QFuture<void> voidFuture = lqt::run_in_thread_async(&t, [&calls] { calls++; });
+    QFuture<QString> text = lqt::then(voidFuture, &context, [] { return QSL("done"); });
+    QTRY_VERIFY(text.isFinished());
+    QCOMPARE(text.result(), QSL("done"));
+    QCOMPARE(calls, 1);
+
+    // The future is canceled when the object is destroyed first.
+    QObject* o = new QObject;
+    o->moveToThread(&t);
+    QSemaphore blocked;
+    lqt::run_in_thread(&t, [&blocked] { blocked.acquire(); });
+    lqt::run_in_thread(&t, [o] { delete o; });
+    QFuture<int> canceled = lqt::run_in_thread_async(o, [] { return 1; });
+    QFuture<int> never = lqt::then(canceled, &context, [&calls] (int value) {
+        calls++;
+        return value;
+    });
+    blocked.release();
+    QTRY_VERIFY(never.isFinished());
+    QVERIFY(canceled.isCanceled());
+    QVERIFY(never.isCanceled());
+    QCOMPARE(calls, 1);
+
+    // The future is canceled when the event is discarded.
+    QSemaphore hold;
+    QScopedPointer<QThread> noLoop(QThread::create([&hold] { hold.acquire(); }));
+    noLoop->start();
+    QFuture<int> dropped = lqt::run_in_thread_async(noLoop.data(), [] { return 1; });
+    hold.release();
+    QVERIFY(noLoop->wait(5000));
+    QTRY_VERIFY(dropped.isFinished());
+    QVERIFY(dropped.isCanceled());
+
+    t.quit();
+    QVERIFY(t.wait(5000));
+}
+
+#ifdef LQT_HAS_COROUTINES
+static lqt::Task<int> lqt_coro_compute(QThread* worker, int value)
+{
+    co_await lqt::resume_on(worker);
+    if (QThread::currentThread() != worker)
+        co_return -1;
+    co_return value*2;
+}
+
+static lqt::Task<> lqt_coro_workflow(QThread* worker, QObject* context, int* result, bool* sameThread)
+{
+    const int value = co_await lqt_coro_compute(worker, 21);
+    const bool alive = co_await lqt::resume_on(context);
+    *sameThread = alive && QThread::currentThread() == context->thread();
+    *result = value;
+}
+
+static lqt::Task<int> lqt_coro_abandoned(QThread* worker, std::shared_ptr<int> frame)
+{
+    co_await lqt::resume_on(worker);
+    co_return *frame;
+}
+
+static lqt::Task<> lqt_coro_await_abandoned(QThread* worker, std::shared_ptr<int> frame, bool* threw)
+{
+    try {
+        co_await lqt_coro_abandoned(worker, frame);
+    }
+    catch (const std::runtime_error&) {
+        *threw = true;
+    }
+}
+#endif
+
+void LQtUtilsTest::test_case55()
+{
+#ifdef LQT_HAS_COROUTINES
+    QThread worker;
+    worker.start();
+
+    QObject context;
+    int result = 0;
+    bool sameThread = false;
+    lqt::Task<> task = lqt_coro_workflow(&worker, &context, &result, &sameThread);
+    QTRY_VERIFY(task.isDone());
+    QCOMPARE(result, 42);
+    QVERIFY(sameThread);
+
+    // A detached task keeps running.
+    result = 0;
+    lqt_coro_workflow(&worker, &context, &result, &sameThread);
+    QTRY_COMPARE(result, 42);
+
+    worker.quit();
+    QVERIFY(worker.wait(5000));
+
+    // When the resume event is discarded, detached frames are destroyed and
+    // awaiting coroutines get an exception.
+    QSemaphore hold;
+    QScopedPointer<QThread> noLoop(QThread::create([&hold] { hold.acquire(2); }));
+    noLoop->start();
+    std::shared_ptr<int> frame = std::make_shared<int>(1);
+    lqt_coro_abandoned(noLoop.data(), frame);
+    bool threw = false;
+    lqt::Task<> awaiting = lqt_coro_await_abandoned(noLoop.data(), frame, &threw);
+    QCOMPARE(frame.use_count(), long(4));
+    hold.release(2);
+    QVERIFY(noLoop->wait(5000));
+    QVERIFY(awaiting.isDone());
+    QVERIFY(threw);
+    QCOMPARE(frame.use_count(), long(2));
+#else
+    QSKIP("Coroutines are not available with this compiler or standard");
+#endif
+}
+
+static void lqt_busy_wait(qint64 ns)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.nsecsElapsed() < ns) {}
+}
+
+void LQtUtilsTest::test_case56()
+{
+    lqt::Executor executor(4);
+    QCOMPARE(executor.threadCount(), 4);
+    QCOMPARE(lqt::Executor::currentWorker(), -1);
+
+    std::atomic<qint64> sum(0);
+    for (int i = 0; i < 10000; i++)
+        executor.post([&sum, i] { sum += i; });
+    executor.waitForDone();
+    QVERIFY(sum == qint64(10000)*9999/2);
+
+    QFuture<int> future = executor.submit([] { return lqt::Executor::currentWorker(); });
+    QVERIFY(future.result() >= 0);
+    std::unique_ptr<int> value = std::make_unique<int>(5);
+    QCOMPARE(executor.submit([value = std::move(value)] { return *value; }).result(), 5);
+
+    // Tasks posted from a worker run in the same executor.
+    std::atomic<int> nested(0);
+    for (int i = 0; i < 10; i++) {
+        executor.post([&executor, &nested] {
+            for (int j = 0; j < 10; j++)
+                executor.post([&nested] { nested++; });
+        });
+    }
+    executor.waitForDone();
+    QCOMPARE(nested.load(), 100);
+
+    // Higher priorities run first.
+    lqt::Executor single(1);
+    QSemaphore started;
+    QSemaphore release;
+    QList<int> order;
+    single.post([&] { started.release(); release.acquire(); });
+    started.acquire();
+    for (int i = 0; i < 3; i++) {
+        single.post([&order, i] { order.append(i); }, lqt::Executor::Low);
+        single.post([&order, i] { order.append(10 + i); }, lqt::Executor::High);
+    }
+    release.release();
+    single.waitForDone();
+    QCOMPARE(order, QList<int>({ 10, 11, 12, 0, 1, 2 }));
+
+    lqt::Executor pinned(2, true);
+    QVERIFY(pinned.submit([] { return true; }).result());
+}
+
+void LQtUtilsTest::test_case57()
+{
+    QVector<int> values(100000);
+    for (int i = 0; i < values.size(); i++)
+        values[i] = i;
+
+    std::atomic<qint64> sum(0);
+    QVERIFY(lqt::parallel_for(0, values.size(), [&values, &sum] (qsizetype i) { sum += values[i]; }));
+    QVERIFY(sum == qint64(values.size())*(values.size() - 1)/2);
+
+    const QVector<qint64> squares = lqt::parallel_transform(values, [] (int v) { return qint64(v)*v; });
+    QCOMPARE(squares.size(), values.size());
+    QCOMPARE(squares[999], qint64(999)*999);
+
+    QStringList rects;
+    for (int i = 0; i < 1000; i++)
+        rects.append(lqt::string_from_rect(QRectF(i, 0, 10, 10)));
+    const QVector<QRectF> parsed = lqt::parallel_transform(rects, [] (const QString& s) {
+        return lqt::string_to_rect(s);
+    });
+    QCOMPARE(parsed.size(), rects.size());
+    QCOMPARE(parsed[500], QRectF(500, 0, 10, 10));
+
+    const qint64 reduced = lqt::parallel_reduce(values, qint64(0), [] (int v) { return qint64(v); },
+                                                [] (qint64 a, qint64 b) { return a + b; });
+    QCOMPARE(reduced, qint64(values.size())*(values.size() - 1)/2);
+
+    // Partial results are combined in order.
+    lqt::ParallelOptions options;
+    options.grainSize = 1;
+    const QString joined = lqt::parallel_reduce(QStringList({ "a", "b", "c", "d" }), QString(),
+                                                [] (const QString& s) { return s; },
+                                                [] (const QString& a, const QString& b) { return a + b; },
+                                                options);
+    QCOMPARE(joined, QString("abcd"));
+
+    // Calls from a worker do not deadlock, the caller processes chunks too.
+    lqt::Executor executor(2);
+    options.executor = &executor;
+    options.grainSize = 0;
+    QFuture<qint64> nested = executor.submit([&values, &options] {
+        return lqt::parallel_reduce(values, qint64(0), [] (int v) { return qint64(v); },
+                                    [] (qint64 a, qint64 b) { return a + b; }, options);
+    });
+    QCOMPARE(nested.result(), reduced);
+
+    std::atomic<bool> cancel(false);
+    std::atomic<int> calls(0);
+    options.grainSize = 10;
+    options.cancel = &cancel;
+    QVERIFY(!lqt::parallel_for(0, values.size(), [&cancel, &calls] (qsizetype) {
+        if (++calls == 500)
+            cancel = true;
+    }, options));
+    QVERIFY(calls < values.size());
+
+    // Canceled transforms and reductions are reported through completed.
+    bool completed = false;
+    QCOMPARE(lqt::parallel_transform(values, [] (int v) { return v; }, lqt::ParallelOptions(), &completed).size(),
+             values.size());
+    QVERIFY(completed);
+    cancel = false;
+    calls = 0;
+    const QVector<int> partial = lqt::parallel_transform(values, [&cancel, &calls] (int v) {
+        if (++calls == 500)
+            cancel = true;
+        return v + 1;
+    }, options, &completed);
+    QVERIFY(!completed);
+    QCOMPARE(partial.size(), values.size());
+    QVERIFY(partial.contains(0));
+
+    completed = false;
+    QCOMPARE(lqt::parallel_reduce(values, qint64(0), [] (int v) { return qint64(v); },
+                                  [] (qint64 a, qint64 b) { return a + b; }, lqt::ParallelOptions(), &completed),
+             reduced);
+    QVERIFY(completed);
+    cancel = false;
+    calls = 0;
+    const qint64 partialSum = lqt::parallel_reduce(values, qint64(0), [&cancel, &calls] (int v) {
+        if (++calls == 500)
+            cancel = true;
+        return qint64(v);
+    }, [] (qint64 a, qint64 b) { return a + b; }, options, &completed);
+    QVERIFY(!completed);
+    QVERIFY(partialSum < reduced);
+}
+
+void LQtUtilsTest::test_case58()
+{
+    QThread t;
+    t.start();
+
+    const int count = 1E4;
+    QList<int> order;
+    QAtomicInt done(0);
+    bool sameThread = true;
+    lqt::DispatchBatcher batcher(64);
+    for (int i = 0; i < count; i++) {
+        batcher.post(&t, [&order, &done, &sameThread, &t, i] {
+            sameThread = sameThread && QThread::currentThread() == &t;
+            order.append(i);
+            done.fetchAndAddRelease(1);
+        });
+    }
+    QTRY_COMPARE_WITH_TIMEOUT(done.loadAcquire(), count, 10000);
+    QVERIFY(sameThread);
+    for (int i = 0; i < count; i++)
+        QCOMPARE(order[i], i);
+    QCOMPARE(batcher.batchCount() + batcher.coalescedCount(), qint64(count));
+    QVERIFY(batcher.batchCount() >= count/batcher.maxBatchSize());
+
+    // Calls are held until the delay expires or the batch is full.
+    lqt::DispatchBatcher delayed(100, 200);
+    done.storeRelaxed(0);
+    for (int i = 0; i < 10; i++)
+        delayed.post(&t, [&done] { done.fetchAndAddRelaxed(1); });
+    QTest::qWait(50);
+    QCOMPARE(done.loadRelaxed(), 0);
+    QTRY_COMPARE_WITH_TIMEOUT(done.loadRelaxed(), 10, 5000);
+    QCOMPARE(delayed.batchCount(), qint64(1));
+    QCOMPARE(delayed.coalescedCount(), qint64(9));
+
+    for (int i = 0; i < 100; i++)
+        delayed.post(&t, [&done] { done.fetchAndAddRelaxed(1); });
+    QTRY_COMPARE_WITH_TIMEOUT(done.loadRelaxed(), 110, 100);
+
+    delayed.post(&t, [&done] { done.fetchAndAddRelaxed(1); });
+    delayed.flush();
+    QTRY_COMPARE_WITH_TIMEOUT(done.loadRelaxed(), 111, 100);
+
+    // Calls still pending when the thread finishes are dropped and the
+    // thread can be used again after a restart.
+    std::shared_ptr<int> captured = std::make_shared<int>(0);
+    lqt::DispatchBatcher stalled(100, 60000);
+    stalled.post(&t, [captured] { (*captured)++; });
+    QTest::qWait(50);
+    t.quit();
+    QVERIFY(t.wait(5000));
+    QCOMPARE(captured.use_count(), long(1));
+    QCOMPARE(*captured, 0);
+
+    t.start();
+    stalled.post(&t, [&done] { done.fetchAndAddRelaxed(1); });
+    stalled.flush();
+    QTRY_COMPARE_WITH_TIMEOUT(done.loadRelaxed(), 112, 1000);
+
+    t.quit();
+    QVERIFY(t.wait(5000));
+}
+
+void LQtUtilsTest::test_case59()
+{
+    std::unique_ptr<int> value = std::make_unique<int>(5);
+    lqt::UniqueFunction<int(int)> moveOnly([value = std::move(value)] (int i) { return *value + i; });
+    QCOMPARE(moveOnly(1), 6);
+    lqt::UniqueFunction<int(int)> moved = std::move(moveOnly);
+    QVERIFY(!moveOnly);
+    QCOMPARE(moved(2), 7);
+    QVERIFY(!lqt::UniqueFunction<void()>(std::function<void()>()));
+
+    // A capture of four pointers, as large as the inline buffer: it is stored
+    // inline, so UniqueFunction and AutoExec do not allocate.
+    qint64 sum = 0;
+    qint64 a = 1, b = 2, c = 3;
+    auto large = [&sum, pa = &a, pb = &b, pc = &c] { sum += *pa + *pb + *pc; };
+    QVERIFY(lqt::UniqueFunction<void()>::isInline<decltype(large)>);
+    lqt::UniqueFunction<void()> inlined(large);
+    inlined();
+    QCOMPARE(sum, qint64(6));
+    {
+        lqt::AutoExec exec(large);
+    }
+    QCOMPARE(sum, qint64(12));
+
+    // measure_time and run_in_thread_sync never wrap the callables, so they
+    // also accept move-only ones.
+    std::unique_ptr<qint64> step = std::make_unique<qint64>(1);
+    qint64 elapsed = -1;
+    lqt::measure_time([&sum, step = std::move(step)] { sum += *step; }, [&elapsed] (qint64 time) { elapsed = time; });
+    QCOMPARE(sum, qint64(13));
+    QVERIFY(elapsed >= 0);
+    QCOMPARE(lqt::measure_time([] { return 5; }), 5);
+
+    QThread t;
+    t.start();
+    std::unique_ptr<qint64> offset = std::make_unique<qint64>(2);
+    lqt::run_in_thread_sync(&t, [&sum, offset = std::move(offset)] { sum += *offset; });
+    QCOMPARE(sum, qint64(15));
+    QCOMPARE(lqt::run_in_thread_sync(&t, [&t] { return QThread::currentThread() == &t; }), true);
+    t.quit();
+    QVERIFY(t.wait(5000));
+}
+
+struct LQTTestAccount
+{
+    qint64 balance = 0;
+    bool ordered = true;
+    int last = -1;
+    lqt::Actor<int, qint64> actor { [this] (int& amount) {
+        ordered = ordered && amount == last + 1;
+        last = amount;
+        balance += amount;
+        return balance;
+    } };
+};
+
+void LQtUtilsTest::test_case60()
+{
+    LQTTestAccount account;
+    for (int i = 0; i < 1000; i++)
+        QVERIFY(account.actor.tell(i));
+    QCOMPARE(account.actor.ask(1000).result(), qint64(1000)*1001/2);
+    QVERIFY(account.ordered);
+    QCOMPARE(account.actor.processedCount(), qint64(1001));
+
+    // Ten thousand actors multiplexed on two threads.
+    lqt::Executor executor(2);
+    std::atomic<qint64> received(0);
+    std::vector<std::unique_ptr<lqt::Actor<QString>>> actors;
+    for (int i = 0; i < 1E4; i++) {
+        actors.emplace_back(new lqt::Actor<QString>([&received] (QString& s) {
+            received += s.size();
+        }, 16, &executor));
+    }
+
+    for (int i = 0; i < 10; i++) {
+        for (std::unique_ptr<lqt::Actor<QString>>& actor : actors)
+            QVERIFY(actor->tell(QSL("ab")));
+    }
+    for (std::unique_ptr<lqt::Actor<QString>>& actor : actors)
+        actor->stop();
+    QCOMPARE(received.load(), qint64(actors.size())*10*2);
+    QVERIFY(!actors[0]->tell(QSL("stopped")));
+    QVERIFY(actors[0]->ask(QSL("stopped")).isCanceled());
+    actors.clear();
+
+    // A bounded mailbox applies backpressure to the senders.
+    lqt::Executor single(1);
+    QSemaphore started;
+    QSemaphore release;
+    lqt::Actor<int> slow([&started, &release] (int&) {
+        started.release();
+        release.acquire();
+    }, 2, &single);
+    QVERIFY(slow.tell(0));
+    QVERIFY(started.tryAcquire(1, 5000));
+    QVERIFY(slow.tell(1));
+    QVERIFY(slow.tell(2));
+    QCOMPARE(slow.size(), 2);
+    QVERIFY(!slow.tell(3, 0));
+    QVERIFY(!slow.tell(3, 50));
+    QVERIFY(slow.ask(3, 0).isCanceled());
+    release.release(3);
+    QVERIFY(slow.tell(3, 5000));
+    release.release();
+    slow.stop();
+    QCOMPARE(slow.processedCount(), qint64(4));
+}
+
+void LQtUtilsTest::test_case61()
+{
+    std::atomic<qint64> sum(0);
+    auto pipeline = lqt::PipelineBuilder<QString>(QSL("ingest"))
+            .stage(QSL("decode"), [] (QString& s) { return s.toInt(); })
+            .stage(QSL("transform"), [] (int& v) {
+                lqt_busy_wait(10000);
+                return qint64(v)*2;
+            }, 4, 16)
+            .stage(QSL("write"), [&sum] (qint64& v) { sum += v; }, 1, 16)
+            .build();
+    QCOMPARE(pipeline->stageCount(), 3);
+
+    const int count = 1000;
+    for (int i = 0; i < count; i++)
+        QVERIFY(pipeline->push(QString::number(i)));
+    pipeline->close();
+    QVERIFY(!pipeline->push(QSL("0")));
+    pipeline->waitForFinished();
+    QCOMPARE(sum.load(), qint64(count)*(count - 1));
+
+    const QList<lqt::PipelineStageStats> stats = pipeline->stats();
+    QCOMPARE(stats.size(), 3);
+    QCOMPARE(stats[1].name, QSL("transform"));
+    QCOMPARE(stats[1].workers, 4);
+    for (const lqt::PipelineStageStats& s : stats) {
+        QCOMPARE(s.processed, qint64(count));
+        QVERIFY(s.throughput > 0);
+        QVERIFY(s.utilization >= 0 && s.utilization <= 1);
+        QVERIFY(s.queue.highWaterMark <= s.queue.capacity);
+    }
+    QCOMPARE(pipeline->bottleneck(), 1);
+
+    // With one worker per stage the order is preserved, and destroying the
+    // pipeline drains it.
+    QList<int> order;
+    {
+        auto ordered = lqt::PipelineBuilder<int>()
+                .stage(QSL("increment"), [] (int& v) { return v + 1; })
+                .stage(QSL("collect"), [&order] (int& v) { order.append(v); })
+                .build();
+        for (int i = 0; i < count; i++)
+            ordered->push(i);
+    }
+    QCOMPARE(order.size(), count);
+    for (int i = 0; i < count; i++)
+        QCOMPARE(order[i], i + 1);
+
+    // Disposing discards the pending elements.
+    std::atomic<int> processed(0);
+    auto disposed = lqt::PipelineBuilder<int>()
+            .stage(QSL("slow"), [&processed] (int& v) {
+                QThread::msleep(10);
+                processed++;
+                return v;
+            }, 1, 16)
+            .stage(QSL("sink"), [] (int&) {})
+            .build();
+    for (int i = 0; i < 10; i++)
+        disposed->push(i);
+    disposed->requestDispose();
+    disposed->waitForFinished();
+    QVERIFY(processed < 10);
+    QVERIFY(!disposed->push(0));
+}
+
+void LQtUtilsTest::test_case62()
+{
+    lqt::TimerWheel wheel;
+    QElapsedTimer timer;
+    timer.start();
+
+    const int count = 20000;
+    int fired = 0;
+    bool early = false;
+    QList<lqt::TimerWheel::Handle> handles;
+    for (int i = 0; i < count; i++) {
+        const int msec = i%500;
+        handles.append(wheel.schedule(msec, [&fired, &early, &timer, msec] {
+            fired++;
+            early = early || timer.elapsed() < msec;
+        }));
+    }
+    QCOMPARE(wheel.pendingCount(), count);
+
+    int canceled = 0;
+    for (int i = 0; i < count; i += 4) {
+        QVERIFY(wheel.cancel(handles[i]));
+        QVERIFY(!wheel.isScheduled(handles[i]));
+        QVERIFY(!wheel.cancel(handles[i]));
+        canceled++;
+    }
+    QCOMPARE(wheel.pendingCount(), count - canceled);
+
+    // Callbacks can cancel or schedule other callbacks.
+    lqt::TimerWheel::Handle victim = wheel.schedule(100, [&early] { early = true; });
+    bool rescheduled = false;
+    wheel.schedule(99, [&wheel, &rescheduled, victim] {
+        wheel.cancel(victim);
+        wheel.schedule(0, [&rescheduled] { rescheduled = true; });
+    });
+
+    QTRY_COMPARE_WITH_TIMEOUT(fired, count - canceled, 5000);
+    QTRY_VERIFY_WITH_TIMEOUT(rescheduled, 1000);
+    QVERIFY(!early);
+    QCOMPARE(wheel.pendingCount(), 0);
+
+    // An idle wheel catches up with the clock when a callback is scheduled.
+    QTest::qWait(300);
+    QElapsedTimer idle;
+    idle.start();
+    qint64 firedAt = -1;
+    wheel.schedule(20, [&firedAt, &idle] { firedAt = idle.elapsed(); });
+    QTRY_VERIFY(firedAt >= 0);
+    QVERIFY(firedAt >= 20 - wheel.resolution());
+    QVERIFY(firedAt < 100);
+
+    // Longer delays go through the higher levels of the wheel.
+    lqt::TimerWheel coarse(10);
+    bool longFired = false;
+    coarse.schedule(3000, [&longFired] { longFired = true; });
+    QTest::qWait(2500);
+    QVERIFY(!longFired);
+    QTRY_VERIFY_WITH_TIMEOUT(longFired, 2000);
+
+    // The QML API returns handles that can be canceled.
+    QJSEngine engine;
+    lqt::QmlUtils utils;
+    engine.globalObject().setProperty(QSL("utils"), engine.newQObject(&utils));
+    QQmlEngine::setObjectOwnership(&utils, QQmlEngine::CppOwnership);
+    engine.evaluate(QSL("var calls = 0;"
+                        "var h1 = utils.singleShot(10, function() { calls++; });"
+                        "var h2 = utils.singleShot(10, function() { calls += 10; });"
+                        "var canceled = utils.cancelSingleShot(h2);"));
+    QVERIFY(engine.globalObject().property(QSL("canceled")).toBool());
+    QTRY_COMPARE_WITH_TIMEOUT(engine.globalObject().property(QSL("calls")).toInt(), 1, 1000);
+    QTest::qWait(50);
+    QCOMPARE(engine.globalObject().property(QSL("calls")).toInt(), 1);
+    QVERIFY(!engine.evaluate(QSL("utils.cancelSingleShot(h1)")).toBool());
+}
+
+void LQtUtilsTest::test_case63()
+{
+    // Coalesced: one notification per iteration of the event loop.
+    LRateLimitTest obj;
+    QSignalSpy counterSpy(&obj, &LRateLimitTest::counterChanged);
+    for (int i = 1; i <= 1000; i++)
+        obj.set_counter(i);
+    QCOMPARE(obj.counter(), 1000);
+    QCOMPARE(counterSpy.count(), 0);
+    QTRY_COMPARE(counterSpy.count(), 1);
+    QTest::qWait(20);
+    QCOMPARE(counterSpy.count(), 1);
+    QCOMPARE(obj.counterLimiter()->triggerCount(), quint64(1000));
+
+    // Throttled: at most one notification per interval, the last value is
+    // always notified.
+    QSignalSpy positionSpy(&obj, &LRateLimitTest::positionChanged);
+    QElapsedTimer timer;
+    timer.start();
+    int last = 0;
+    while (timer.elapsed() < 300) {
+        obj.set_position(++last);
+        QCoreApplication::processEvents();
+    }
+    QTRY_COMPARE(obj.positionLimiter()->isPending(), false);
+    QTest::qWait(50);
+    QVERIFY(positionSpy.count() >= 2);
+    QVERIFY(positionSpy.count() <= 300/20 + 2);
+    QCOMPARE(obj.position(), last);
+
+    // Setters can be called by workers, notifications are emitted in the
+    // thread of the object.
+    positionSpy.clear();
+    bool wrongThread = false;
+    connect(&obj, &LRateLimitTest::positionChanged, this, [&obj, &wrongThread] {
+        wrongThread = wrongThread || QThread::currentThread() != obj.thread();
+    });
+    QScopedPointer<QThread> setter(QThread::create([&obj] {
+        for (int i = 1; i <= 100000; i++)
+            obj.set_position(i);
+    }));
+    setter->start();
+    while (!setter->isFinished())
+        QTest::qWait(10);
+    QTRY_COMPARE(obj.positionLimiter()->isPending(), false);
+    QCOMPARE(obj.position(), 100000);
+    QVERIFY(positionSpy.count() >= 1);
+    QVERIFY(!wrongThread);
+
+    // Debounced: notified once changes stop for the interval.
+    QSignalSpy querySpy(&obj, &LRateLimitTest::queryChanged);
+    for (const QString& query : { QSL("l"), QSL("lq"), QSL("lqt"), QSL("lqtu") }) {
+        obj.set_query(query);
+        QTest::qWait(5);
+    }
+    QCOMPARE(querySpy.count(), 0);
+    QTRY_COMPARE(querySpy.count(), 1);
+    QTest::qWait(60);
+    QCOMPARE(querySpy.count(), 1);
+    QCOMPARE(obj.query(), QSL("lqtu"));
+
+    // Limiters can be attached to any signal and triggered by other threads.
+    std::atomic<bool> stop(false);
+    int calls = 0;
+    lqt::SignalRateLimiter* limiter = lqt::throttle(&obj, &LRateLimitTest::counterChanged, 20, &obj, [&calls] {
+        calls++;
+    });
+    QScopedPointer<QThread> worker(QThread::create([limiter, &stop] {
+        while (!stop)
+            limiter->trigger();
+    }));
+    worker->start();
+    QTest::qWait(200);
+    stop = true;
+    worker->wait();
+    QTRY_VERIFY(!limiter->isPending());
+    QVERIFY(calls >= 2);
+    QVERIFY(calls <= 200/20 + 2);
+    QVERIFY(limiter->triggerCount() > quint64(calls));
+    QCOMPARE(limiter->emitCount(), quint64(calls));
+
+    lqt::SignalRateLimiter debouncer(lqt::SignalRateLimiter::Debounce, 50);
+    QSignalSpy debouncerSpy(&debouncer, &lqt::SignalRateLimiter::triggered);
+    debouncer.trigger();
+    debouncer.cancel();
+    QTest::qWait(80);
+    QCOMPARE(debouncerSpy.count(), 0);
+    debouncer.trigger();
+    debouncer.flush();
+    QCOMPARE(debouncerSpy.count(), 1);
+    QTest::qWait(80);
+    QCOMPARE(debouncerSpy.count(), 1);
+}
+
+void LQtUtilsTest::test_case64()
+{
+    // Results are discarded when the signature returns void, like std::function.
+    int calls = 0;
+    {
+        lqt::AutoExec exec([&calls] { return ++calls; });
+    }
+    QCOMPARE(calls, 1);
+    {
+        lqt::SharedAutoExec exec([&calls] { return ++calls > 1; });
+    }
+    QCOMPARE(calls, 2);
+
+    lqt::UniqueFunction<void()> inlined([&calls] { return ++calls; });
+    inlined();
+    QCOMPARE(calls, 3);
+
+    std::array<int, 16> steps;
+    steps.fill(2);
+    auto large = [&calls, steps] { return calls += steps[0]; };
+    QVERIFY(!lqt::UniqueFunction<void()>::isInline<decltype(large)>);
+    lqt::UniqueFunction<void()> allocated(large);
+    allocated();
+    QCOMPARE(calls, 5);
+
+    lqt::UniqueFunction<void(int)> withArgs([&calls] (int i) { return calls += i; });
+    withArgs(3);
+    QCOMPARE(calls, 8);
+}
+
 QTEST_GUILESS_MAIN(LQtUtilsTest)
 
 #include "tst_lqtutils.moc"
@@ -0,0 +1,270 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Luca Carlon
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef LQTUTILS_ACTOR_H
+#define LQTUTILS_ACTOR_H
+
+#include <QString>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QDeadlineTimer>
+#include <QFuture>
+#include <QFutureInterface>
+
+#include <atomic>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "lqtutils_bqueue.h"
+#include "lqtutils_executor.h"
+#include "lqtutils_function.h"
+
+namespace lqt {
+
+/**
+ * @brief The Actor class owns a typed mailbox whose messages are processed
+ * one at a time by a handler, so the state touched by the handler needs no
+ * locking. Actors do not own threads: an actor with pending messages is
+ * scheduled on an Executor and processes at most throughput messages before
+ * yielding the worker to other actors, so many actors share a few threads.
+ * tell() sends a message, ask() also returns a future with the reply of the
+ * handler. When the mailbox is bounded, senders wait for space up to a
+ * timeout. Sending to a full mailbox from a handler running in the same
+ * executor should use a timeout of 0, as blocking a worker may deadlock.
+ *
+ * The actor is usually a member of the object owning the state, declared
+ * after the state, so it is stopped before the state is destroyed.
+ */
+template<typename Message, typename Reply = void>
+class Actor
+{
+public:
+    typedef UniqueFunction<Reply(Message&)> Handler;
+
+    template<typename F>
+    explicit Actor(F&& handler, int capacity = -1, Executor* executor = nullptr, int throughput = 64, const QString& name = QString());
+    ~Actor() { stop(); }
+
+    bool tell(const Message& message, qint64 timeout = -1) { return send(Message(message), nullptr, timeout); }
+    bool tell(Message&& message, qint64 timeout = -1) { return send(std::move(message), nullptr, timeout); }
+    QFuture<Reply> ask(const Message& message, qint64 timeout = -1) { return ask(Message(message), timeout); }
+    QFuture<Reply> ask(Message&& message, qint64 timeout = -1);
+    void stop();
+
+    int size() const;
+    int capacity() const { return m_capacity; }
+    bool isStopped() const;
+    qint64 processedCount() const { return m_processed.load(std::memory_order_relaxed); }
+    QString name() const { return m_name; }
+
+private:
+    Q_DISABLE_COPY(Actor)
+
+    struct Envelope
+    {
+        Message message;
+        std::optional<QFutureInterface<Reply>> promise;
+    };
+
+    bool send(Message&& message, QFutureInterface<Reply>* promise, qint64 timeout);
+    void process();
+
+private:
+    Handler m_handler;
+    Executor* m_executor;
+    const int m_capacity;
+    const int m_throughput;
+    const QString m_name;
+    mutable QMutex m_mutex;
+    QWaitCondition m_changed;
+    RingBuffer<Envelope> m_mailbox;
+    int m_waiters;
+    bool m_scheduled;
+    bool m_stopped;
+    std::atomic<qint64> m_processed;
+};
+
+/**
+ * Creates an actor calling handler for each message. A negative capacity
+ * means the mailbox is unbounded.
+ *
+ * @brief Actor::Actor
+ * @param handler
+ * @param capacity
+ * @param executor Executor processing the messages, nullptr for the global one.
+ * @param throughput Messages processed before yielding the worker.
+ * @param name
+ */
+template<typename Message, typename Reply>
+template<typename F>
+Actor<Message, Reply>::Actor(F&& handler, int capacity, Executor* executor, int throughput, const QString& name) :
+    m_handler(std::forward<F>(handler))
+  , m_executor(executor ? executor : Executor::globalInstance())
+  , m_capacity(capacity)
+  , m_throughput(qMax(1, throughput))
+  , m_name(name)
+  , m_waiters(0)
+  , m_scheduled(false)
+  , m_stopped(false)
+  , m_processed(0)
+{}
+
+/**
+ * Sends message and returns a future reporting the reply of the handler. The
+ * future is canceled if the message cannot be delivered.
+ *
+ * @brief Actor::ask
+ * @param message
+ * @param timeout
+ * @return
+ */
+template<typename Message, typename Reply>
+QFuture<Reply> Actor<Message, Reply>::ask(Message&& message, qint64 timeout)
+{
+    QFutureInterface<Reply> promise;
+    promise.reportStarted();
+    QFuture<Reply> future = promise.future();
+    if (!send(std::move(message), &promise, timeout)) {
+        promise.reportCanceled();
+        promise.reportFinished();
+    }
+    return future;
+}
+
+/**
+ * Refuses new messages and waits until the messages already in the mailbox
+ * are processed. Must not be called by the handler.
+ *
+ * @brief Actor::stop
+ */
+template<typename Message, typename Reply>
+void Actor<Message, Reply>::stop()
+{
+    QMutexLocker locker(&m_mutex);
+    m_stopped = true;
+    m_changed.wakeAll();
+    m_waiters++;
+    while (m_scheduled)
+        m_changed.wait(&m_mutex);
+    m_waiters--;
+}
+
+template<typename Message, typename Reply>
+int Actor<Message, Reply>::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_mailbox.size();
+}
+
+template<typename Message, typename Reply>
+bool Actor<Message, Reply>::isStopped() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stopped;
+}
+
+template<typename Message, typename Reply>
+bool Actor<Message, Reply>::send(Message&& message, QFutureInterface<Reply>* promise, qint64 timeout)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_capacity >= 0 && m_mailbox.size() >= m_capacity) {
+        if (m_capacity == 0)
+            return false;
+
+        const QDeadlineTimer deadline(timeout);
+        m_waiters++;
+        while (!m_stopped && m_mailbox.size() >= m_capacity && !deadline.hasExpired())
+            m_changed.wait(&m_mutex, deadline);
+        m_waiters--;
+        if (m_mailbox.size() >= m_capacity)
+            return false;
+    }
+    if (m_stopped)
+        return false;
+
+    Envelope& e = m_mailbox.emplaceBack(Envelope { std::move(message), std::nullopt });
+    if (promise)
+        e.promise = *promise;
+    if (m_scheduled)
+        return true;
+
+    m_scheduled = true;
+    locker.unlock();
+    m_executor->post([this] { process(); });
+    return true;
+}
+
+/**
+ * Processes up to m_throughput messages in a worker of the executor.
+ */
+template<typename Message, typename Reply>
+void Actor<Message, Reply>::process()
+{
+    for (int i = 0; i < m_throughput; i++) {
+        QMutexLocker locker(&m_mutex);
+        if (m_mailbox.isEmpty()) {
+            m_scheduled = false;
+            if (m_waiters)
+                m_changed.wakeAll();
+            return;
+        }
+
+        Envelope e = m_mailbox.takeFirst();
+        if (m_waiters)
+            m_changed.wakeAll();
+        locker.unlock();
+
+        if constexpr (std::is_void_v<Reply>) {
+            m_handler(e.message);
+            m_processed.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (e.promise) {
+            Reply reply = m_handler(e.message);
+            m_processed.fetch_add(1, std::memory_order_relaxed);
+            e.promise->reportResult(std::move(reply));
+        }
+        else {
+            m_handler(e.message);
+            m_processed.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (e.promise)
+            e.promise->reportFinished();
+    }
+
+    // Yield the worker to the other actors.
+    QMutexLocker locker(&m_mutex);
+    if (m_mailbox.isEmpty()) {
+        m_scheduled = false;
+        if (m_waiters)
+            m_changed.wakeAll();
+        return;
+    }
+    locker.unlock();
+    m_executor->post([this] { process(); });
+}
+
+} // namespace
+
+#endif // LQTUTILS_ACTOR_H
@@ -28,26 +28,34 @@
 #include <QSharedPointer>
 
 #include <functional>
+#include <type_traits>
+#include <utility>
+
+#include "lqtutils_function.h"
 
 namespace lqt {
 
 class AutoExec
 {
 public:
-    AutoExec(std::function<void()> func) { reset(func); }
-    AutoExec() { reset(nullptr); }
+    template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, AutoExec>>>
+    AutoExec(F&& func) { reset(std::forward<F>(func)); }
+    AutoExec() {}
+    AutoExec(AutoExec&& other) = default;
     ~AutoExec() { if (m_func) m_func(); }
-    void reset(std::function<void()> func) { m_func = func; }
-    void reset() { reset(nullptr); }
+    template<typename F> void reset(F&& func) { m_func = std::forward<F>(func); }
+    void reset() { m_func = nullptr; }
 private:
-    std::function<void()> m_func;
+    // Small captures are stored inline, so scope guards do not allocate.
+    UniqueFunction<void()> m_func;
 };
 
 class SharedAutoExec
 {
 public:
-    SharedAutoExec(std::function<void()> func) :
-        m_exec(new AutoExec(func)) {}
+    template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, SharedAutoExec>>>
+    SharedAutoExec(F&& func) :
+        m_exec(new AutoExec(std::forward<F>(func))) {}
     SharedAutoExec() {}
 
 protected:
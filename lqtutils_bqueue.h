@@ -28,148 +28,1277 @@
 #include <QString>
 #include <QMutex>
 #include <QWaitCondition>
+#include <QDeadlineTimer>
 #include <QList>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QThread>
 
+#include <atomic>
 #include <optional>
+#include <iterator>
+#include <limits>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+#include "lqtutils_perf.h"
+
+#ifndef LQT_BQUEUE_MAX_PREALLOC
+#define LQT_BQUEUE_MAX_PREALLOC 65536
+#endif
 
 namespace lqt {
 
+/**
+ * @brief The RingBuffer class is a FIFO of elements stored in place in a
+ * contiguous ring. Elements can also be taken from the back, like a deque.
+ * Storage is only reallocated when reserve() is called or when the ring is
+ * full and an element is appended.
+ */
+template<typename T>
+class RingBuffer
+{
+public:
+    explicit RingBuffer(int capacity = 0);
+    ~RingBuffer() { clear(); }
+
+    int size() const { return m_size; }
+    int capacity() const { return m_capacity; }
+    bool isEmpty() const { return m_size == 0; }
+    bool isFull() const { return m_size == m_capacity; }
+
+    void reserve(int capacity);
+    template<typename... Args> T& emplaceBack(Args&&... args);
+    void append(const T& e) { emplaceBack(e); }
+    void append(T&& e) { emplaceBack(std::move(e)); }
+    T takeFirst();
+    void removeFirst();
+    T takeLast();
+    void removeLast();
+    T& first() { return *slot(m_head); }
+    const T& first() const { return *slot(m_head); }
+    T& last() { return *slot((m_head + m_size - 1) % m_capacity); }
+    const T& last() const { return *slot((m_head + m_size - 1) % m_capacity); }
+    T& operator[](int i) { return *slot((m_head + i) % m_capacity); }
+    const T& operator[](int i) const { return *slot((m_head + i) % m_capacity); }
+    void clear();
+
+private:
+    Q_DISABLE_COPY(RingBuffer)
+
+    struct Slot { alignas(T) unsigned char data[sizeof(T)]; };
+    T* slot(int i) { return std::launder(reinterpret_cast<T*>(m_slots[i].data)); }
+    const T* slot(int i) const { return std::launder(reinterpret_cast<const T*>(m_slots[i].data)); }
+
+private:
+    std::unique_ptr<Slot[]> m_slots;
+    int m_capacity;
+    int m_head;
+    int m_size;
+};
+
+template<typename T>
+RingBuffer<T>::RingBuffer(int capacity) :
+    m_slots(new Slot[qMax(capacity, 0)])
+  , m_capacity(qMax(capacity, 0))
+  , m_head(0)
+  , m_size(0) {}
+
+template<typename T>
+void RingBuffer<T>::reserve(int capacity)
+{
+    if (capacity <= m_capacity)
+        return;
+
+    std::unique_ptr<Slot[]> storage(new Slot[capacity]);
+    for (int i = 0; i < m_size; i++) {
+        T* e = slot((m_head + i) % m_capacity);
+        new (storage[i].data) T(std::move(*e));
+        e->~T();
+    }
+
+    m_slots = std::move(storage);
+    m_capacity = capacity;
+    m_head = 0;
+}
+
+template<typename T>
+template<typename... Args>
+T& RingBuffer<T>::emplaceBack(Args&&... args)
+{
+    if (isFull())
+        reserve(qMax(1, m_capacity*2));
+
+    const int i = (m_head + m_size) % m_capacity;
+    T* e = new (m_slots[i].data) T(std::forward<Args>(args)...);
+    m_size++;
+    return *e;
+}
+
+template<typename T>
+T RingBuffer<T>::takeFirst()
+{
+    T ret(std::move(first()));
+    removeFirst();
+    return ret;
+}
+
+template<typename T>
+void RingBuffer<T>::removeFirst()
+{
+    slot(m_head)->~T();
+    m_head = (m_head + 1) % m_capacity;
+    m_size--;
+}
+
+template<typename T>
+T RingBuffer<T>::takeLast()
+{
+    T ret(std::move(last()));
+    removeLast();
+    return ret;
+}
+
 template<typename T>
+void RingBuffer<T>::removeLast()
+{
+    last().~T();
+    m_size--;
+}
+
+template<typename T>
+void RingBuffer<T>::clear()
+{
+    while (!isEmpty())
+        removeFirst();
+    m_head = 0;
+}
+
+/**
+ * @brief The PriorityHeap class is a binary heap that can be used as storage
+ * of a BlockingQueue. first() is the element with the highest priority
+ * according to Compare, like in std::priority_queue. Elements with the same
+ * priority are kept in insertion order.
+ */
+template<typename T, typename Compare = std::less<T>>
+class PriorityHeap
+{
+public:
+    explicit PriorityHeap(int capacity = 0, const Compare& compare = Compare()) :
+        m_compare(compare), m_seq(0) { reserve(capacity); }
+
+    int size() const { return static_cast<int>(m_heap.size()); }
+    bool isEmpty() const { return m_heap.empty(); }
+
+    void reserve(int capacity) { m_heap.reserve(static_cast<size_t>(qMax(capacity, 0))); }
+    template<typename... Args> void emplaceBack(Args&&... args);
+    void append(const T& e) { emplaceBack(e); }
+    void append(T&& e) { emplaceBack(std::move(e)); }
+    T takeFirst();
+    void removeFirst();
+    T& first() { return m_heap.front().value; }
+    const T& first() const { return m_heap.front().value; }
+
+private:
+    struct Entry
+    {
+        T value;
+        quint64 seq;
+    };
+
+    // Returns true if a must be dequeued after b.
+    bool lower(const Entry& a, const Entry& b) const {
+        if (m_compare(a.value, b.value))
+            return true;
+        if (m_compare(b.value, a.value))
+            return false;
+        return a.seq > b.seq;
+    }
+
+private:
+    Compare m_compare;
+    quint64 m_seq;
+    std::vector<Entry> m_heap;
+};
+
+template<typename T, typename Compare>
+template<typename... Args>
+void PriorityHeap<T, Compare>::emplaceBack(Args&&... args)
+{
+    m_heap.push_back(Entry { T(std::forward<Args>(args)...), m_seq++ });
+    std::push_heap(m_heap.begin(), m_heap.end(), [this] (const Entry& a, const Entry& b) {
+        return lower(a, b);
+    });
+}
+
+template<typename T, typename Compare>
+T PriorityHeap<T, Compare>::takeFirst()
+{
+    std::pop_heap(m_heap.begin(), m_heap.end(), [this] (const Entry& a, const Entry& b) {
+        return lower(a, b);
+    });
+    T ret(std::move(m_heap.back().value));
+    m_heap.pop_back();
+    return ret;
+}
+
+template<typename T, typename Compare>
+void PriorityHeap<T, Compare>::removeFirst()
+{
+    takeFirst();
+}
+
+template<typename S> struct is_fifo_storage : std::true_type {};
+template<typename T, typename C> struct is_fifo_storage<PriorityHeap<T, C>> : std::false_type {};
+
+// Storage deciding by itself whether an element fits, see BlockingQueue.
+template<typename S, typename T, typename = void> struct has_element_fits : std::false_type {};
+template<typename S, typename T>
+struct has_element_fits<S, T, std::void_t<decltype(std::declval<S&>().fits(std::declval<const T&>(), 0))>> : std::true_type {};
+
+// Storage that can lose elements, see BlockingQueue.
+template<typename S, typename = void> struct has_lost_elements : std::false_type {};
+template<typename S>
+struct has_lost_elements<S, std::void_t<decltype(std::declval<S&>().takeLost())>> : std::true_type {};
+
+/**
+ * @brief The BlockWaitPolicy struct is the default wait policy of a
+ * BlockingQueue: threads waiting for elements or free space go straight to
+ * QWaitCondition::wait.
+ */
+struct BlockWaitPolicy
+{
+    static constexpr bool spins = false;
+    template<typename Pred>
+    static bool wait(Pred ready, const QDeadlineTimer&) { return ready(); }
+};
+
+/**
+ * @brief The SpinWaitPolicy struct makes waiting threads spin up to MaxSpins
+ * CPU relax instructions, with exponential backoff, before blocking. It trades
+ * CPU for wakeup latency when the other side is expected to act soon. On a
+ * single core, spinning would only delay the other side, so it blocks.
+ */
+template<int MaxSpins = 4096>
+struct SpinWaitPolicy
+{
+    static constexpr bool spins = true;
+    template<typename Pred>
+    static bool wait(Pred ready, const QDeadlineTimer& deadline) {
+        static const bool multicore = QThread::idealThreadCount() > 1;
+        if (!multicore)
+            return ready();
+
+        int backoff = 1;
+        for (int spun = 0; spun < MaxSpins && !deadline.hasExpired(); spun += backoff) {
+            if (ready())
+                return true;
+            for (int i = 0; i < backoff; i++)
+                LC_CPU_RELAX();
+            backoff = qMin(backoff*2, 64);
+        }
+        return ready();
+    }
+};
+
+/**
+ * @brief The YieldWaitPolicy struct makes waiting threads yield the CPU up to
+ * MaxYields times before blocking. Cheaper than spinning when there are more
+ * busy threads than cores.
+ */
+template<int MaxYields = 64>
+struct YieldWaitPolicy
+{
+    static constexpr bool spins = true;
+    template<typename Pred>
+    static bool wait(Pred ready, const QDeadlineTimer& deadline) {
+        for (int i = 0; i < MaxYields && !deadline.hasExpired(); i++) {
+            if (ready())
+                return true;
+            QThread::yieldCurrentThread();
+        }
+        return ready();
+    }
+};
+
+/**
+ * @brief The QueueStats struct is a snapshot of the statistics of a queue.
+ * Counters are always collected; blocked and residence times are only
+ * collected when statistics are enabled on the queue.
+ */
+struct QueueStats
+{
+    QString name;
+    int size = 0;
+    int capacity = 0;
+    qint64 enqueued = 0;
+    qint64 dequeued = 0;
+    qint64 dropped = 0;
+    int highWaterMark = 0;
+    // Time producers spent waiting for free space.
+    qint64 producerBlockedNs = 0;
+    // Time consumers spent waiting for elements.
+    qint64 consumerBlockedNs = 0;
+    // Time elements spent in the queue. Only available for FIFO storage.
+    qint64 residenceP50Ns = 0;
+    qint64 residenceP90Ns = 0;
+    qint64 residenceP99Ns = 0;
+    qint64 residenceMaxNs = 0;
+};
+
+/**
+ * @brief The QueueObserver class is notified by a BlockingQueue when it
+ * becomes non-empty or when it is disposed. The callback is invoked with the
+ * queue locked, so it must not call the queue back.
+ */
+class QueueObserver
+{
+public:
+    virtual ~QueueObserver() = default;
+    virtual void queueReady() = 0;
+};
+
+/**
+ * @brief The BlockingQueue class is a bounded FIFO with blocking insertion and
+ * removal. Elements are stored in a ring allocated at construction (up to
+ * LQT_BQUEUE_MAX_PREALLOC elements, growing up to the capacity when larger),
+ * so the steady state does not allocate. Move-only types are supported.
+ * A different Storage, like PriorityHeap, changes the order of removal. A
+ * Storage defining bool fits(const T& e, int capacity) decides by itself
+ * whether e can be added, e.g. by its size in bytes: producers wait until it
+ * returns true. Such a Storage also defines appendChecked(e), called with the
+ * queue still locked to add the element last passed to fits(), so that the
+ * work done by fits() can be reused. A Storage that can lose elements, e.g.
+ * because they cannot be read back, defines int takeLost(), returning how
+ * many were lost since the last call: they are counted as dropped.
+ * WaitPolicy decides how threads wait for elements or free space before
+ * blocking on the condition variables: BlockWaitPolicy, SpinWaitPolicy or
+ * YieldWaitPolicy.
+ */
+template<typename T, typename Storage = RingBuffer<T>, typename WaitPolicy = BlockWaitPolicy>
 class BlockingQueue
 {
 public:
     BlockingQueue(int capacity, const QString& name = QString()) :
-        m_capacity(capacity), m_disposed(false), m_name(name) {}
-    bool enqueue(const T& e, qint64 timeout = -1);
-    bool enqueueDropFirst(const T& e, qint64 timeout = -1);
+        m_capacity(capacity), m_disposed(false), m_name(name)
+      , m_queue(qMin(capacity, LQT_BQUEUE_MAX_PREALLOC)), m_statsEnabled(false), m_size(0) { m_clock.start(); }
+    bool enqueue(const T& e, qint64 timeout = -1) { return emplaceWithTimeout(timeout, e); }
+    bool enqueue(T&& e, qint64 timeout = -1) { return emplaceWithTimeout(timeout, std::move(e)); }
+    template<typename... Args> bool emplace(Args&&... args) { return emplaceWithTimeout(-1, std::forward<Args>(args)...); }
+    template<typename... Args> bool emplaceWithTimeout(qint64 timeout, Args&&... args);
+    bool enqueueDropFirst(const T& e, qint64 timeout = -1) { return pushDropFirst(e, timeout); }
+    bool enqueueDropFirst(T&& e, qint64 timeout = -1) { return pushDropFirst(std::move(e), timeout); }
+    bool enqueueOverwrite(const T& e) { return pushOverwrite(e); }
+    bool enqueueOverwrite(T&& e) { return pushOverwrite(std::move(e)); }
+    template<typename Range> int enqueueMany(Range&& range, qint64 timeout = -1);
     std::optional<T> waitFirst(bool remove, qint64 timeout = -1);
     std::optional<T> dequeue(qint64 timeout = -1);
     std::optional<T> peek(qint64 timeout = -1);
+    QList<T> dequeueUpTo(int maxCount, qint64 timeout = -1);
     int size() const;
     int capacity() const { return m_capacity; }
     bool isEmpty() const;
     bool isDisposed() const;
     void requestDispose();
     void lockQueue(std::function<void(QList<T>* queue)> callback);
-    QString name() { return m_name; }
+    QString name() const { return m_name; }
+    void addObserver(QueueObserver* observer);
+    void removeObserver(QueueObserver* observer);
+    QueueStats stats() const;
+    void resetStats();
+    void setStatsEnabled(bool enabled);
+    bool statsEnabled() const;
+
+protected:
+    template<typename... StorageArgs>
+    BlockingQueue(int capacity, const QString& name, std::in_place_t, StorageArgs&&... storageArgs) :
+        m_capacity(capacity), m_disposed(false), m_name(name)
+      , m_queue(std::forward<StorageArgs>(storageArgs)...), m_statsEnabled(false), m_size(0) { m_clock.start(); }
+
+    // Runs f with the storage locked, for queues built on their own storage.
+    template<typename F> decltype(auto) withStorage(F&& f) { QMutexLocker locker(&m_mutex); return f(m_queue); }
+    template<typename F> decltype(auto) withStorage(F&& f) const { QMutexLocker locker(&m_mutex); return f(m_queue); }
+
+private:
+    static constexpr bool fitsElement = has_element_fits<Storage, T>::value;
+
+    void notifyReady();
+    void onPushed(int count);
+    void onPopped(int count);
+    void onDropped();
+    void onLost();
+    void resetTimestamps();
+    template<typename U> bool pushDropFirst(U&& e, qint64 timeout);
+    template<typename U> bool pushOverwrite(U&& e);
+    bool push(T&& e, qint64 timeout);
+    template<typename U> bool hasRoom(const U* e);
+    template<typename U> void appendChecked(U&& e);
+    void wakeProducers(int count);
+    template<typename U> bool waitNotFull(qint64 timeout, const U* e);
+    bool waitNotEmpty(qint64 timeout);
+    template<typename Pred> void spin(Pred ready, const QDeadlineTimer& deadline);
+    void publishSize();
 
 private:
     int m_capacity;
-    bool m_disposed;
+    std::atomic<bool> m_disposed;
     QString m_name;
     mutable QMutex m_mutex;
     QWaitCondition m_condFull;
     QWaitCondition m_condEmpty;
-    QList<T> m_queue;
+    Storage m_queue;
+    QList<QueueObserver*> m_observers;
+    bool m_statsEnabled;
+    QueueStats m_stats;
+    QElapsedTimer m_clock;
+    RingBuffer<qint64> m_timestamps;
+    LatencyHistogram m_residence;
+    // Size readable without the lock, only maintained when the policy spins.
+    std::atomic<int> m_size;
 };
 
-template<typename T>
-bool BlockingQueue<T>::enqueue(const T& e, qint64 timeout)
+/**
+ * Runs the wait policy with m_mutex unlocked. Must be called with m_mutex
+ * locked.
+ */
+template<typename T, typename Storage, typename WaitPolicy>
+template<typename Pred>
+void BlockingQueue<T, Storage, WaitPolicy>::spin(Pred ready, const QDeadlineTimer& deadline)
+{
+    if constexpr (WaitPolicy::spins) {
+        m_mutex.unlock();
+        WaitPolicy::wait(ready, deadline);
+        m_mutex.lock();
+    }
+    else {
+        Q_UNUSED(ready)
+        Q_UNUSED(deadline)
+    }
+}
+
+template<typename T, typename Storage, typename WaitPolicy>
+void BlockingQueue<T, Storage, WaitPolicy>::publishSize()
+{
+    if constexpr (WaitPolicy::spins)
+        m_size.store(m_queue.size(), std::memory_order_release);
+}
+
+/**
+ * Returns true if e, or any element when e is null, can be added. Must be
+ * called with m_mutex locked.
+ */
+template<typename T, typename Storage, typename WaitPolicy>
+template<typename U>
+bool BlockingQueue<T, Storage, WaitPolicy>::hasRoom(const U* e)
+{
+    if constexpr (fitsElement) {
+        if (e)
+            return m_queue.fits(*e, m_capacity);
+    }
+    return m_queue.size() < m_capacity;
+}
+
+/**
+ * Adds e after hasRoom(&e) was called. Must be called with m_mutex locked.
+ */
+template<typename T, typename Storage, typename WaitPolicy>
+template<typename U>
+void BlockingQueue<T, Storage, WaitPolicy>::appendChecked(U&& e)
+{
+    // Elements of other types were converted to be checked.
+    if constexpr (fitsElement && std::is_same_v<std::decay_t<U>, T>)
+        m_queue.appendChecked(std::forward<U>(e));
+    else
+        m_queue.append(std::forward<U>(e));
+}
+
+/**
+ * Wakes the producers after count elements were removed. Must be called with
+ * m_mutex locked.
+ */
+template<typename T, typename Storage, typename WaitPolicy>
+void BlockingQueue<T, Storage, WaitPolicy>::wakeProducers(int count)
+{
+    // When the room depends on the element, one removal may let several
+    // waiting producers in.
+    if (count == 1 && !fitsElement)
+        m_condFull.wakeOne();
+    else
+        m_condFull.wakeAll();
+}
+
+/**
+ * Waits until e, or any element when e is null, can be added. Must be called
+ * with m_mutex locked.
+ */
+template<typename T, typename Storage, typename WaitPolicy>
+template<typename U>
+bool BlockingQueue<T, Storage, WaitPolicy>::waitNotFull(qint64 timeout, const U* e)
 {
-    QMutexLocker locker(&m_mutex);
     if (m_disposed)
         return false;
-    if (m_queue.size() >= m_capacity) {
-        if (!m_condFull.wait(&m_mutex, timeout))
-            return false;
-        if (m_disposed)
+    if (hasRoom(e))
+        return true;
+
+    const QDeadlineTimer deadline(timeout);
+    QElapsedTimer blocked;
+    blocked.start();
+    // When the room depends on the element, it cannot be checked without the
+    // lock: spin until something is removed.
+    const int target = fitsElement ? m_queue.size() : m_capacity;
+    spin([this, target] {
+        return m_disposed.load(std::memory_order_acquire) || m_size.load(std::memory_order_acquire) < target;
+    }, deadline);
+    bool ret = !m_disposed;
+    while (ret && !hasRoom(e)) {
+        if (!m_condFull.wait(&m_mutex, deadline) || m_disposed) {
+            ret = false;
+            break;
+        }
+    }
+
+    if (m_statsEnabled)
+        m_stats.producerBlockedNs += blocked.nsecsElapsed();
+    return ret;
+}
+
+/**
+ * Waits for an element. Must be called with m_mutex locked.
+ */
+template<typename T, typename Storage, typename WaitPolicy>
+bool BlockingQueue<T, Storage, WaitPolicy>::waitNotEmpty(qint64 timeout)
+{
+    if (m_disposed)
+        return false;
+    if (!m_queue.isEmpty())
+        return true;
+    if (!timeout)
+        return false;
+
+    const QDeadlineTimer deadline(timeout);
+    QElapsedTimer blocked;
+    blocked.start();
+    spin([this] {
+        return m_disposed.load(std::memory_order_acquire) || m_size.load(std::memory_order_acquire) > 0;
+    }, deadline);
+    bool ret = !m_disposed;
+    while (ret && m_queue.isEmpty()) {
+        if (!m_condEmpty.wait(&m_mutex, deadline) || m_disposed) {
+            ret = false;
+            break;
+        }
+    }
+
+    if (m_statsEnabled)
+        m_stats.consumerBlockedNs += blocked.nsecsElapsed();
+    return ret;
+}
+
+template<typename T, typename Storage, typename WaitPolicy>
+template<typename... Args>
+bool BlockingQueue<T, Storage, WaitPolicy>::emplaceWithTimeout(qint64 timeout, Args&&... args)
+{
+    // The storage needs the element to tell whether it fits.
+    if constexpr (fitsElement) {
+        return push(T(std::forward<Args>(args)...), timeout);
+    }
+    else {
+        QMutexLocker locker(&m_mutex);
+        if (!waitNotFull<T>(timeout, nullptr))
             return false;
+
+        m_queue.emplaceBack(std::forward<Args>(args)...);
+        onPushed(1);
+        m_condEmpty.wakeOne();
+        if (m_queue.size() == 1)
+            notifyReady();
+
+        return true;
     }
+}
 
-    m_queue.append(e);
+template<typename T, typename Storage, typename WaitPolicy>
+bool BlockingQueue<T, Storage, WaitPolicy>::push(T&& e, qint64 timeout)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!waitNotFull(timeout, &e))
+        return false;
+
+    appendChecked(std::move(e));
+    onPushed(1);
     m_condEmpty.wakeOne();
+    if (m_queue.size() == 1)
+        notifyReady();
 
     return true;
 }
 
-template<typename T>
-bool BlockingQueue<T>::enqueueDropFirst(const T& e, qint64 timeout)
+template<typename T, typename Storage, typename WaitPolicy>
+template<typename U>
+bool BlockingQueue<T, Storage, WaitPolicy>::pushDropFirst(U&& e, qint64 timeout)
 {
+    // The first element of a priority heap is the most important one.
+    static_assert(is_fifo_storage<Storage>::value, "enqueueDropFirst requires FIFO storage");
+
     QMutexLocker locker(&m_mutex);
     if (m_disposed)
         return false;
-    if (m_queue.size() >= m_capacity) {
-        if (!m_condFull.wait(&m_mutex, timeout))
-            if (!m_queue.isEmpty())
-                m_queue.takeFirst();
-        if (m_disposed)
-            return false;
+    if (!hasRoom(&e)) {
+        const QDeadlineTimer deadline(timeout);
+        QElapsedTimer blocked;
+        blocked.start();
+        while (!hasRoom(&e)) {
+            if (!m_condFull.wait(&m_mutex, deadline)) {
+                while (!hasRoom(&e) && !m_queue.isEmpty()) {
+                    m_queue.removeFirst();
+                    onDropped();
+                    onLost();
+                }
+                break;
+            }
+            if (m_disposed)
+                return false;
+        }
+        if (m_statsEnabled)
+            m_stats.producerBlockedNs += blocked.nsecsElapsed();
     }
 
-    m_queue.append(e);
+    appendChecked(std::forward<U>(e));
+    onPushed(1);
     m_condEmpty.wakeOne();
+    if (m_queue.size() == 1)
+        notifyReady();
 
     return true;
 }
 
-template<typename T>
-std::optional<T> BlockingQueue<T>::waitFirst(bool remove, qint64 timeout)
+/**
+ * Enqueues an element without ever waiting: when the queue is full, the oldest
+ * element is discarded immediately and counted as dropped. Useful when the
+ * latest value is all that matters and producers must not be slowed down by
+ * consumers. Only available for FIFO storage.
+ *
+ * @brief BlockingQueue::enqueueOverwrite
+ * @param e
+ * @return false if the queue was disposed.
+ */
+template<typename T, typename Storage, typename WaitPolicy>
+template<typename U>
+bool BlockingQueue<T, Storage, WaitPolicy>::pushOverwrite(U&& e)
 {
+    static_assert(is_fifo_storage<Storage>::value, "enqueueOverwrite requires FIFO storage");
+
     QMutexLocker locker(&m_mutex);
-    if (m_disposed)
-        return std::nullopt;
-    if (m_queue.isEmpty()) {
-        if (!timeout)
-            return std::nullopt;
-        if (!m_condEmpty.wait(&m_mutex, timeout))
-            return std::nullopt;
-        if (m_disposed)
-            return std::nullopt;
+    if (m_disposed || m_capacity <= 0)
+        return false;
+    while (!hasRoom(&e) && !m_queue.isEmpty()) {
+        m_queue.removeFirst();
+        onDropped();
+        onLost();
     }
 
-    std::optional<T> ret = remove ? m_queue.takeFirst() : m_queue.first();
-    if (remove)
-        m_condFull.wakeOne();
+    appendChecked(std::forward<U>(e));
+    onPushed(1);
+    m_condEmpty.wakeOne();
+    if (m_queue.size() == 1)
+        notifyReady();
+
+    return true;
+}
+
+/**
+ * Enqueues the elements of range with a single lock acquisition, waiting up to
+ * timeout for free space. Only the elements fitting the free space are taken.
+ * Elements are moved when range is an rvalue.
+ *
+ * @brief BlockingQueue::enqueueMany
+ * @param range
+ * @param timeout
+ * @return The number of elements accepted.
+ */
+template<typename T, typename Storage, typename WaitPolicy>
+template<typename Range>
+int BlockingQueue<T, Storage, WaitPolicy>::enqueueMany(Range&& range, qint64 timeout)
+{
+    QMutexLocker locker(&m_mutex);
+    if (std::begin(range) == std::end(range))
+        return 0;
+    if (!waitNotFull(timeout, std::addressof(*std::begin(range))))
+        return 0;
+
+    int accepted = 0;
+    for (auto it = std::begin(range); it != std::end(range) && hasRoom(std::addressof(*it)); ++it) {
+        if constexpr (std::is_rvalue_reference_v<Range&&>)
+            appendChecked(std::move(*it));
+        else
+            appendChecked(*it);
+        accepted++;
+    }
+    onPushed(accepted);
+
+    if (accepted == 1)
+        m_condEmpty.wakeOne();
+    else
+        m_condEmpty.wakeAll();
+    if (accepted == m_queue.size())
+        notifyReady();
+
+    return accepted;
+}
+
+template<typename T, typename Storage, typename WaitPolicy>
+std::optional<T> BlockingQueue<T, Storage, WaitPolicy>::waitFirst(bool remove, qint64 timeout)
+{
+    return remove ? dequeue(timeout) : peek(timeout);
+}
+
+template<typename T, typename Storage, typename WaitPolicy>
+std::optional<T> BlockingQueue<T, Storage, WaitPolicy>::dequeue(qint64 timeout)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!waitNotEmpty(timeout))
+        return std::nullopt;
+
+    std::optional<T> ret(m_queue.takeFirst());
+    onPopped(1);
+    onLost();
+    wakeProducers(1);
     return ret;
 }
 
-template<typename T>
-std::optional<T> BlockingQueue<T>::dequeue(qint64 timeout)
+template<typename T, typename Storage, typename WaitPolicy>
+std::optional<T> BlockingQueue<T, Storage, WaitPolicy>::peek(qint64 timeout)
 {
-    return waitFirst(true, timeout);
+    QMutexLocker locker(&m_mutex);
+    if (!waitNotEmpty(timeout))
+        return std::nullopt;
+
+    return m_queue.first();
 }
 
-template<typename T>
-std::optional<T> BlockingQueue<T>::peek(qint64 timeout)
+/**
+ * Dequeues up to maxCount elements with a single lock acquisition, waiting up
+ * to timeout for the first one.
+ *
+ * @brief BlockingQueue::dequeueUpTo
+ * @param maxCount
+ * @param timeout
+ * @return The dequeued elements, empty on timeout or dispose.
+ */
+template<typename T, typename Storage, typename WaitPolicy>
+QList<T> BlockingQueue<T, Storage, WaitPolicy>::dequeueUpTo(int maxCount, qint64 timeout)
 {
-    return waitFirst(false, timeout);
+    QList<T> ret;
+    QMutexLocker locker(&m_mutex);
+    if (maxCount <= 0 || !waitNotEmpty(timeout))
+        return ret;
+
+    ret.reserve(qMin(maxCount, m_queue.size()));
+    // Taking an element may make the storage lose the next ones.
+    while (ret.size() < maxCount && !m_queue.isEmpty())
+        ret.append(m_queue.takeFirst());
+    const int count = int(ret.size());
+    onPopped(count);
+    onLost();
+    wakeProducers(count);
+
+    return ret;
 }
 
-template<typename T>
-int BlockingQueue<T>::size() const
+template<typename T, typename Storage, typename WaitPolicy>
+int BlockingQueue<T, Storage, WaitPolicy>::size() const
 {
     QMutexLocker locker(&m_mutex);
     return m_queue.size();
 }
 
-template<typename T>
-bool BlockingQueue<T>::isEmpty() const
+template<typename T, typename Storage, typename WaitPolicy>
+bool BlockingQueue<T, Storage, WaitPolicy>::isEmpty() const
 {
     QMutexLocker locker(&m_mutex);
     return m_queue.isEmpty();
 }
 
-template<typename T>
-bool BlockingQueue<T>::isDisposed() const
+template<typename T, typename Storage, typename WaitPolicy>
+bool BlockingQueue<T, Storage, WaitPolicy>::isDisposed() const
 {
     QMutexLocker locker(&m_mutex);
     return m_disposed;
 }
 
-template<typename T>
-void BlockingQueue<T>::requestDispose()
+template<typename T, typename Storage, typename WaitPolicy>
+void BlockingQueue<T, Storage, WaitPolicy>::requestDispose()
 {
     QMutexLocker locker(&m_mutex);
     m_disposed = true;
     m_condFull.wakeAll();
     m_condEmpty.wakeAll();
+    notifyReady();
 }
 
-template<typename T>
-void BlockingQueue<T>::lockQueue(std::function<void(QList<T>*)> callback)
+/**
+ * Exposes the content of the queue as a list. Elements are moved into the list
+ * for the duration of the callback and moved back afterwards.
+ *
+ * @brief BlockingQueue::lockQueue
+ * @param callback
+ */
+template<typename T, typename Storage, typename WaitPolicy>
+void BlockingQueue<T, Storage, WaitPolicy>::lockQueue(std::function<void(QList<T>*)> callback)
+{
+    QMutexLocker locker(&m_mutex);
+    QList<T> list;
+    list.reserve(m_queue.size());
+    while (!m_queue.isEmpty())
+        list.append(m_queue.takeFirst());
+    onLost();
+
+    callback(&list);
+
+    m_queue.reserve(static_cast<int>(list.size()));
+    for (T& e : list)
+        m_queue.append(std::move(e));
+    publishSize();
+    resetTimestamps();
+    if (!m_queue.isEmpty())
+        notifyReady();
+}
+
+template<typename T, typename Storage, typename WaitPolicy>
+void BlockingQueue<T, Storage, WaitPolicy>::addObserver(QueueObserver* observer)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_observers.contains(observer))
+        m_observers.append(observer);
+}
+
+template<typename T, typename Storage, typename WaitPolicy>
+void BlockingQueue<T, Storage, WaitPolicy>::removeObserver(QueueObserver* observer)
+{
+    QMutexLocker locker(&m_mutex);
+    m_observers.removeOne(observer);
+}
+
+template<typename T, typename Storage, typename WaitPolicy>
+void BlockingQueue<T, Storage, WaitPolicy>::notifyReady()
+{
+    for (QueueObserver* observer : std::as_const(m_observers))
+        observer->queueReady();
+}
+
+template<typename T, typename Storage, typename WaitPolicy>
+void BlockingQueue<T, Storage, WaitPolicy>::onPushed(int count)
+{
+    publishSize();
+    m_stats.enqueued += count;
+    m_stats.highWaterMark = qMax(m_stats.highWaterMark, m_queue.size());
+    if (!m_statsEnabled || !is_fifo_storage<Storage>::value)
+        return;
+
+    // A storage may merge an element with one already stored.
+    const qint64 now = m_clock.nsecsElapsed();
+    while (m_timestamps.size() < m_queue.size())
+        m_timestamps.append(now);
+}
+
+template<typename T, typename Storage, typename WaitPolicy>
+void BlockingQueue<T, Storage, WaitPolicy>::onPopped(int count)
+{
+    publishSize();
+    m_stats.dequeued += count;
+    if (m_timestamps.isEmpty())
+        return;
+
+    const qint64 now = m_clock.nsecsElapsed();
+    for (int i = 0; i < count && !m_timestamps.isEmpty(); i++)
+        m_residence.add(now - m_timestamps.takeFirst());
+}
+
+template<typename T, typename Storage, typename WaitPolicy>
+void BlockingQueue<T, Storage, WaitPolicy>::onDropped()
+{
+    m_stats.dropped++;
+    if (!m_timestamps.isEmpty())
+        m_timestamps.removeFirst();
+}
+
+/**
+ * Counts the elements lost by the storage as dropped. Must be called with
+ * m_mutex locked after taking elements.
+ */
+template<typename T, typename Storage, typename WaitPolicy>
+void BlockingQueue<T, Storage, WaitPolicy>::onLost()
+{
+    if constexpr (has_lost_elements<Storage>::value) {
+        for (int lost = m_queue.takeLost(); lost > 0; lost--)
+            onDropped();
+    }
+}
+
+template<typename T, typename Storage, typename WaitPolicy>
+void BlockingQueue<T, Storage, WaitPolicy>::resetTimestamps()
+{
+    m_timestamps.clear();
+    if (!m_statsEnabled || !is_fifo_storage<Storage>::value)
+        return;
+
+    m_timestamps.reserve(qMin(m_capacity, LQT_BQUEUE_MAX_PREALLOC));
+    const qint64 now = m_clock.nsecsElapsed();
+    for (int i = 0; i < m_queue.size(); i++)
+        m_timestamps.append(now);
+}
+
+template<typename T, typename Storage, typename WaitPolicy>
+QueueStats BlockingQueue<T, Storage, WaitPolicy>::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    QueueStats ret = m_stats;
+    ret.name = m_name;
+    ret.size = m_queue.size();
+    ret.capacity = m_capacity;
+    ret.residenceP50Ns = m_residence.percentile(50);
+    ret.residenceP90Ns = m_residence.percentile(90);
+    ret.residenceP99Ns = m_residence.percentile(99);
+    ret.residenceMaxNs = m_residence.max();
+    return ret;
+}
+
+template<typename T, typename Storage, typename WaitPolicy>
+void BlockingQueue<T, Storage, WaitPolicy>::resetStats()
+{
+    QMutexLocker locker(&m_mutex);
+    m_stats = QueueStats();
+    m_stats.highWaterMark = m_queue.size();
+    m_residence.reset();
+}
+
+/**
+ * Enables the collection of blocked and residence times. This requires reading
+ * the clock on every operation, so it is disabled by default.
+ *
+ * @brief BlockingQueue::setStatsEnabled
+ * @param enabled
+ */
+template<typename T, typename Storage, typename WaitPolicy>
+void BlockingQueue<T, Storage, WaitPolicy>::setStatsEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_statsEnabled == enabled)
+        return;
+
+    m_statsEnabled = enabled;
+    resetTimestamps();
+}
+
+template<typename T, typename Storage, typename WaitPolicy>
+bool BlockingQueue<T, Storage, WaitPolicy>::statsEnabled() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_statsEnabled;
+}
+
+/**
+ * @brief The QueueSelector class waits on several blocking queues at once,
+ * like select() does for file descriptors. wait() returns the index of a queue
+ * that has elements or was disposed, so the caller can dequeue from it without
+ * waiting. Queues must be added before waiting and must outlive the selector.
+ */
+class QueueSelector : public QueueObserver
+{
+public:
+    QueueSelector() : m_generation(0), m_next(0) {}
+    ~QueueSelector();
+
+    template<typename Q> int add(Q* queue);
+    int count() const { return static_cast<int>(m_entries.size()); }
+    int wait(qint64 timeout = -1);
+    void queueReady() override;
+
+private:
+    Q_DISABLE_COPY(QueueSelector)
+
+    struct Entry
+    {
+        std::function<bool()> ready;
+        std::function<void()> detach;
+    };
+
+private:
+    QMutex m_mutex;
+    QWaitCondition m_cond;
+    quint64 m_generation;
+    int m_next;
+    std::vector<Entry> m_entries;
+};
+
+inline QueueSelector::~QueueSelector()
+{
+    for (const Entry& entry : m_entries)
+        entry.detach();
+}
+
+/**
+ * Adds a queue to the selector.
+ *
+ * @brief QueueSelector::add
+ * @param queue
+ * @return The index returned by wait() when this queue is ready.
+ */
+template<typename Q>
+int QueueSelector::add(Q* queue)
+{
+    m_entries.push_back(Entry {
+        [queue] { return !queue->isEmpty() || queue->isDisposed(); },
+        [this, queue] { queue->removeObserver(this); }
+    });
+    queue->addObserver(this);
+    return count() - 1;
+}
+
+/**
+ * Waits until any of the queues has elements or is disposed. Queues are scanned
+ * round robin, so a busy queue cannot starve the others.
+ *
+ * @brief QueueSelector::wait
+ * @param timeout
+ * @return The index of the ready queue or -1 on timeout.
+ */
+inline int QueueSelector::wait(qint64 timeout)
+{
+    const QDeadlineTimer deadline(timeout);
+    while (true) {
+        quint64 generation;
+        {
+            QMutexLocker locker(&m_mutex);
+            generation = m_generation;
+        }
+
+        const int size = count();
+        for (int i = 0; i < size; i++) {
+            const int index = (m_next + i) % size;
+            if (m_entries[index].ready()) {
+                m_next = (index + 1) % size;
+                return index;
+            }
+        }
+
+        QMutexLocker locker(&m_mutex);
+        while (generation == m_generation) {
+            if (!m_cond.wait(&m_mutex, deadline))
+                return -1;
+        }
+    }
+}
+
+inline void QueueSelector::queueReady()
 {
     QMutexLocker locker(&m_mutex);
-    callback(&m_queue);
+    m_generation++;
+    m_cond.wakeAll();
+}
+
+/**
+ * A BlockingQueue returning elements by priority, with the same capacity,
+ * timeout and dispose semantics. Elements with the same priority are returned
+ * in FIFO order.
+ */
+template<typename T, typename Compare = std::less<T>, typename WaitPolicy = BlockWaitPolicy>
+using PriorityBlockingQueue = BlockingQueue<T, PriorityHeap<T, Compare>, WaitPolicy>;
+
+/**
+ * @brief The ByteBudgetStorage class is the storage of a
+ * ByteBudgetBlockingQueue. Each element is stored with its size in bytes,
+ * computed by sizeOf when it is checked by fits() and reused by
+ * appendChecked(). An element fits when it is within the budget or when the storage is empty.
+ */
+template<typename T, typename SizeOf>
+class ByteBudgetStorage
+{
+public:
+    ByteBudgetStorage(qint64 byteBudget, SizeOf sizeOf) :
+        m_byteBudget(byteBudget), m_sizeOf(std::move(sizeOf)), m_bytes(0), m_checked(nullptr), m_checkedBytes(0) {}
+
+    int size() const { return m_ring.size(); }
+    bool isEmpty() const { return m_ring.isEmpty(); }
+    qint64 bytes() const { return m_bytes; }
+    bool fits(const T& e, int capacity);
+
+    void reserve(int capacity) { m_ring.reserve(capacity); }
+    template<typename... Args> void emplaceBack(Args&&... args) { append(T(std::forward<Args>(args)...)); }
+    void append(const T& e) { push(T(e), qMax<qint64>(0, m_sizeOf(e))); }
+    void append(T&& e) { const qint64 bytes = qMax<qint64>(0, m_sizeOf(e)); push(std::move(e), bytes); }
+    void appendChecked(const T& e) { Q_ASSERT(&e == m_checked); push(T(e), m_checkedBytes); }
+    void appendChecked(T&& e) { Q_ASSERT(&e == m_checked); push(std::move(e), m_checkedBytes); }
+    T takeFirst();
+    void removeFirst() { takeFirst(); }
+    T& first() { return m_ring.first().value; }
+    const T& first() const { return m_ring.first().value; }
+
+private:
+    struct Entry
+    {
+        T value;
+        qint64 bytes;
+    };
+
+    void push(T&& e, qint64 bytes);
+
+private:
+    qint64 m_byteBudget;
+    SizeOf m_sizeOf;
+    qint64 m_bytes;
+    RingBuffer<Entry> m_ring;
+    // The element last checked by fits() and its size.
+    const T* m_checked;
+    qint64 m_checkedBytes;
+};
+
+template<typename T, typename SizeOf>
+bool ByteBudgetStorage<T, SizeOf>::fits(const T& e, int capacity)
+{
+    m_checked = &e;
+    m_checkedBytes = qMax<qint64>(0, m_sizeOf(e));
+    return m_ring.size() < capacity && (m_ring.isEmpty() || m_bytes + m_checkedBytes <= m_byteBudget);
+}
+
+template<typename T, typename SizeOf>
+void ByteBudgetStorage<T, SizeOf>::push(T&& e, qint64 bytes)
+{
+    m_ring.append(Entry { std::move(e), bytes });
+    m_bytes += bytes;
+}
+
+template<typename T, typename SizeOf>
+T ByteBudgetStorage<T, SizeOf>::takeFirst()
+{
+    Entry entry = m_ring.takeFirst();
+    m_bytes -= entry.bytes;
+    return std::move(entry.value);
+}
+
+/**
+ * @brief The ByteBudgetBlockingQueue class is a FIFO blocking queue whose
+ * capacity is a budget of bytes instead of a number of elements. The size of
+ * each element is computed by the sizeOf functor when it is enqueued.
+ * Producers wait until the element fits the remaining budget; an element larger
+ * than the whole budget is accepted only when the queue is empty. The rest of
+ * the API, including statistics and wait policies, is the one of BlockingQueue.
+ */
+template<typename T, typename SizeOf = std::function<qint64(const T&)>, typename WaitPolicy = BlockWaitPolicy>
+class ByteBudgetBlockingQueue : public BlockingQueue<T, ByteBudgetStorage<T, SizeOf>, WaitPolicy>
+{
+public:
+    typedef ByteBudgetStorage<T, SizeOf> Storage;
+
+    ByteBudgetBlockingQueue(qint64 byteBudget, SizeOf sizeOf, const QString& name = QString()) :
+        BlockingQueue<T, Storage, WaitPolicy>(std::numeric_limits<int>::max(), name, std::in_place, byteBudget, std::move(sizeOf))
+      , m_byteBudget(byteBudget) {}
+
+    qint64 bytesInFlight() const { return this->withStorage([] (const Storage& storage) { return storage.bytes(); }); }
+    qint64 byteBudget() const { return m_byteBudget; }
+
+private:
+    qint64 m_byteBudget;
+};
+
+/**
+ * @brief The CoalescingStorage class is the storage of a
+ * CoalescingBlockingQueue. Elements are key/value pairs and appending a key
+ * that is already stored replaces its value in place. A pair always fits if
+ * its key is stored, otherwise the capacity is the number of distinct keys.
+ */
+template<typename K, typename V>
+class CoalescingStorage
+{
+public:
+    explicit CoalescingStorage(int capacity = 0) : m_order(qMax(capacity, 0)), m_coalesced(0) { m_values.reserve(qMax(capacity, 0)); }
+
+    int size() const { return m_order.size(); }
+    bool isEmpty() const { return m_order.isEmpty(); }
+    bool contains(const K& key) const { return m_values.contains(key); }
+    qint64 coalescedCount() const { return m_coalesced; }
+    bool fits(const std::pair<K, V>& e, int capacity) const { return m_order.size() < capacity || m_values.contains(e.first); }
+
+    void reserve(int capacity) { m_order.reserve(capacity); m_values.reserve(capacity); }
+    template<typename... Args> void emplaceBack(Args&&... args) { append(std::pair<K, V>(std::forward<Args>(args)...)); }
+    void append(const std::pair<K, V>& e) { push(e.first, e.second); }
+    void append(std::pair<K, V>&& e) { push(e.first, std::move(e.second)); }
+    void appendChecked(const std::pair<K, V>& e) { append(e); }
+    void appendChecked(std::pair<K, V>&& e) { append(std::move(e)); }
+    std::pair<K, V> takeFirst();
+    void removeFirst() { m_values.remove(m_order.first()); m_order.removeFirst(); }
+    std::pair<K, V> first() const { return std::make_pair(m_order.first(), m_values.value(m_order.first())); }
+
+private:
+    template<typename U> void push(const K& key, U&& value);
+
+private:
+    RingBuffer<K> m_order;
+    QHash<K, V> m_values;
+    qint64 m_coalesced;
+};
+
+template<typename K, typename V>
+template<typename U>
+void CoalescingStorage<K, V>::push(const K& key, U&& value)
+{
+    auto it = m_values.find(key);
+    if (it != m_values.end()) {
+        it.value() = std::forward<U>(value);
+        m_coalesced++;
+        return;
+    }
+
+    m_order.append(key);
+    m_values.insert(key, std::forward<U>(value));
+}
+
+template<typename K, typename V>
+std::pair<K, V> CoalescingStorage<K, V>::takeFirst()
+{
+    K key = m_order.takeFirst();
+    V value = m_values.take(key);
+    return std::make_pair(std::move(key), std::move(value));
+}
+
+/**
+ * @brief The CoalescingBlockingQueue class is a blocking queue of key/value
+ * pairs keeping only the latest value for each key. Enqueueing a key that is
+ * still pending replaces its value and keeps its original position, so
+ * consumers never see stale intermediate values. The capacity is the number of
+ * distinct pending keys; replacing a pending value never waits. The rest of
+ * the API, including statistics and wait policies, is the one of BlockingQueue.
+ */
+template<typename K, typename V, typename WaitPolicy = BlockWaitPolicy>
+class CoalescingBlockingQueue : public BlockingQueue<std::pair<K, V>, CoalescingStorage<K, V>, WaitPolicy>
+{
+public:
+    typedef CoalescingStorage<K, V> Storage;
+
+    CoalescingBlockingQueue(int capacity, const QString& name = QString()) :
+        BlockingQueue<std::pair<K, V>, Storage, WaitPolicy>(capacity, name) {}
+
+    bool enqueue(const K& key, const V& value, qint64 timeout = -1) { return this->emplaceWithTimeout(timeout, key, value); }
+    bool enqueue(const K& key, V&& value, qint64 timeout = -1) { return this->emplaceWithTimeout(timeout, key, std::move(value)); }
+    bool contains(const K& key) const { return this->withStorage([&key] (const Storage& storage) { return storage.contains(key); }); }
+    qint64 coalescedCount() const;
+};
+
+/**
+ * Returns how many values were replaced by newer ones before being dequeued.
+ *
+ * @brief CoalescingBlockingQueue::coalescedCount
+ * @return
+ */
+template<typename K, typename V, typename WaitPolicy>
+qint64 CoalescingBlockingQueue<K, V, WaitPolicy>::coalescedCount() const
+{
+    return this->withStorage([] (const Storage& storage) { return storage.coalescedCount(); });
 }
 
 }
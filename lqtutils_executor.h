@@ -0,0 +1,325 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Luca Carlon
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef LQTUTILS_EXECUTOR_H
+#define LQTUTILS_EXECUTOR_H
+
+#include <QString>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QDeadlineTimer>
+#include <QThread>
+#include <QFuture>
+#include <QFutureInterface>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "lqtutils_bqueue.h"
+#include "lqtutils_lfqueue.h"
+
+namespace lqt {
+
+/**
+ * @brief The Executor class is a thread pool for many small tasks. Each worker
+ * has its own deques, one per priority: tasks posted from a worker go to its
+ * own deques, the others are spread round robin. A worker takes from the front
+ * of its own deque and, when it is empty, steals from the back of the others,
+ * always looking at higher priorities first. Idle workers park until new tasks
+ * are posted. Workers can optionally be pinned to a CPU (Linux only).
+ */
+class Executor
+{
+public:
+    enum Priority { Low, Normal, High, PriorityCount };
+
+    explicit Executor(int threads = QThread::idealThreadCount(), bool pinThreads = false);
+    ~Executor();
+
+    static Executor* globalInstance();
+
+    template<typename F> void post(F&& f, Priority priority = Normal);
+    template<typename F, typename R = std::invoke_result_t<std::decay_t<F>&>>
+    QFuture<R> submit(F&& f, Priority priority = Normal);
+    void waitForDone();
+    int threadCount() const { return m_threadCount; }
+    qint64 stolenCount() const { return m_stolen.load(std::memory_order_relaxed); }
+    static int currentWorker();
+
+private:
+    Q_DISABLE_COPY(Executor)
+
+    class Job
+    {
+    public:
+        virtual ~Job() = default;
+        virtual void run() = 0;
+    };
+
+    template<typename F>
+    class FunctorJob : public Job
+    {
+    public:
+        template<typename U> explicit FunctorJob(U&& f) : m_f(std::forward<U>(f)) {}
+        void run() override { m_f(); }
+    private:
+        F m_f;
+    };
+
+    typedef std::unique_ptr<Job> JobPtr;
+
+    struct alignas(LC_CACHE_LINE_SIZE) Worker
+    {
+        QMutex mutex;
+        RingBuffer<JobPtr> queues[PriorityCount];
+        std::thread thread;
+    };
+
+    struct Current
+    {
+        const Executor* executor = nullptr;
+        int index = -1;
+    };
+
+    static Current& current() { static thread_local Current c; return c; }
+    void enqueue(JobPtr job, Priority priority);
+    JobPtr take(int index);
+    void run(int index);
+
+private:
+    const int m_threadCount;
+    const bool m_pinThreads;
+    std::unique_ptr<Worker[]> m_workers;
+    std::atomic<quint32> m_next;
+    alignas(LC_CACHE_LINE_SIZE) std::atomic<int> m_pending[PriorityCount];
+    alignas(LC_CACHE_LINE_SIZE) std::atomic<int> m_pendingTotal;
+    alignas(LC_CACHE_LINE_SIZE) std::atomic<qint64> m_inflight;
+    std::atomic<qint64> m_stolen;
+    std::atomic<bool> m_stopping;
+    EventCount m_notEmpty;
+    QMutex m_idleMutex;
+    QWaitCondition m_idle;
+};
+
+inline Executor::Executor(int threads, bool pinThreads) :
+    m_threadCount(qMax(1, threads))
+  , m_pinThreads(pinThreads)
+  , m_workers(new Worker[qMax(1, threads)])
+  , m_next(0)
+  , m_pendingTotal(0)
+  , m_inflight(0)
+  , m_stolen(0)
+  , m_stopping(false)
+{
+    for (std::atomic<int>& pending : m_pending)
+        pending.store(0, std::memory_order_relaxed);
+    for (int i = 0; i < m_threadCount; i++)
+        m_workers[i].thread = std::thread([this, i] { run(i); });
+}
+
+/**
+ * Waits for all the posted tasks to complete and stops the workers. Must not
+ * be called from one of the workers of this executor, see waitForDone().
+ */
+inline Executor::~Executor()
+{
+    waitForDone();
+    m_stopping.store(true, std::memory_order_seq_cst);
+    m_notEmpty.notifyAll();
+    for (int i = 0; i < m_threadCount; i++)
+        m_workers[i].thread.join();
+}
+
+/**
+ * Returns an executor shared by the whole process, with one worker per core.
+ *
+ * @brief Executor::globalInstance
+ * @return
+ */
+inline Executor* Executor::globalInstance()
+{
+    static Executor executor;
+    return &executor;
+}
+
+/**
+ * Runs f in one of the workers.
+ *
+ * @brief Executor::post
+ * @param f
+ * @param priority
+ */
+template<typename F>
+void Executor::post(F&& f, Priority priority)
+{
+    enqueue(JobPtr(new FunctorJob<std::decay_t<F>>(std::forward<F>(f))), priority);
+}
+
+/**
+ * Runs f in one of the workers.
+ *
+ * @brief Executor::submit
+ * @param f
+ * @param priority
+ * @return A future reporting the result of f.
+ */
+template<typename F, typename R>
+QFuture<R> Executor::submit(F&& f, Priority priority)
+{
+    QFutureInterface<R> promise;
+    promise.reportStarted();
+    QFuture<R> future = promise.future();
+    post([promise, f = std::forward<F>(f)] () mutable {
+        if constexpr (std::is_void_v<R>)
+            f();
+        else
+            promise.reportResult(f());
+        promise.reportFinished();
+    }, priority);
+    return future;
+}
+
+/**
+ * Waits until all the posted tasks, including those posted meanwhile, have
+ * completed. Must not be called from a task of this executor: the calling
+ * task is among those being waited for, so it would never return.
+ *
+ * @brief Executor::waitForDone
+ */
+inline void Executor::waitForDone()
+{
+    Q_ASSERT(currentWorker() < 0 || current().executor != this);
+    QMutexLocker locker(&m_idleMutex);
+    while (m_inflight.load(std::memory_order_acquire) > 0)
+        m_idle.wait(&m_idleMutex);
+}
+
+/**
+ * Returns the index of the worker of the current executor running the calling
+ * thread, or -1 when not called from a worker.
+ *
+ * @brief Executor::currentWorker
+ * @return
+ */
+inline int Executor::currentWorker()
+{
+    return current().index;
+}
+
+inline void Executor::enqueue(JobPtr job, Priority priority)
+{
+    const Current& c = current();
+    const int index = c.executor == this
+            ? c.index
+            : static_cast<int>(m_next.fetch_add(1, std::memory_order_relaxed) % quint32(m_threadCount));
+
+    m_inflight.fetch_add(1, std::memory_order_relaxed);
+    {
+        Worker& worker = m_workers[index];
+        QMutexLocker locker(&worker.mutex);
+        worker.queues[priority].append(std::move(job));
+        m_pending[priority].fetch_add(1, std::memory_order_release);
+        m_pendingTotal.fetch_add(1, std::memory_order_release);
+    }
+
+    m_notEmpty.notifyOne();
+}
+
+/**
+ * Takes the job with the highest priority, from the front of the deque of
+ * the worker or from the back of the deques of the others.
+ */
+inline Executor::JobPtr Executor::take(int index)
+{
+    for (int priority = High; priority >= Low; priority--) {
+        if (m_pending[priority].load(std::memory_order_acquire) <= 0)
+            continue;
+
+        for (int i = 0; i < m_threadCount; i++) {
+            Worker& worker = m_workers[(index + i) % m_threadCount];
+            QMutexLocker locker(&worker.mutex);
+            RingBuffer<JobPtr>& queue = worker.queues[priority];
+            if (queue.isEmpty())
+                continue;
+
+            JobPtr job = i == 0 ? queue.takeFirst() : queue.takeLast();
+            m_pending[priority].fetch_sub(1, std::memory_order_relaxed);
+            m_pendingTotal.fetch_sub(1, std::memory_order_relaxed);
+            if (i)
+                m_stolen.fetch_add(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+
+    return nullptr;
+}
+
+inline void Executor::run(int index)
+{
+    current().executor = this;
+    current().index = index;
+
+#ifdef Q_OS_LINUX
+    if (m_pinThreads) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(index % qMax(1, QThread::idealThreadCount()), &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+#endif
+
+    const QDeadlineTimer forever(QDeadlineTimer::Forever);
+    while (true) {
+        if (JobPtr job = take(index)) {
+            job->run();
+            job.reset();
+            if (m_inflight.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                QMutexLocker locker(&m_idleMutex);
+                m_idle.wakeAll();
+            }
+            continue;
+        }
+
+        if (m_stopping.load(std::memory_order_acquire))
+            break;
+
+        m_notEmpty.wait([this] {
+            return m_pendingTotal.load(std::memory_order_acquire) > 0 || m_stopping.load(std::memory_order_acquire);
+        }, forever, LQT_LFQUEUE_SPIN_COUNT);
+    }
+
+    current() = Current();
+}
+
+} // namespace
+
+#endif // LQTUTILS_EXECUTOR_H
@@ -0,0 +1,174 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Luca Carlon
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef LQTUTILS_FUNCTION_H
+#define LQTUTILS_FUNCTION_H
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace lqt {
+
+template<typename Signature, size_t Capacity = 4*sizeof(void*)>
+class UniqueFunction;
+
+/**
+ * @brief The UniqueFunction class is a move-only replacement for std::function.
+ * Callables up to Capacity bytes, with a non-throwing move constructor, are
+ * stored inline, so wrapping them never allocates. Larger callables are moved
+ * to the heap. Unlike std::function, move-only callables are supported.
+ */
+template<typename R, typename... Args, size_t Capacity>
+class UniqueFunction<R(Args...), Capacity>
+{
+public:
+    template<typename F>
+    static constexpr bool isInline = sizeof(F) <= Capacity
+                                     && alignof(F) <= alignof(std::max_align_t)
+                                     && std::is_nothrow_move_constructible_v<F>;
+
+    UniqueFunction() noexcept {}
+    UniqueFunction(std::nullptr_t) noexcept {}
+    template<typename F,
+             typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, UniqueFunction>
+                                         && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>>>
+    UniqueFunction(F&& f) { assign(std::forward<F>(f)); }
+    UniqueFunction(UniqueFunction&& other) noexcept { moveFrom(other); }
+    ~UniqueFunction() { clear(); }
+
+    UniqueFunction& operator=(UniqueFunction&& other) noexcept;
+    UniqueFunction& operator=(std::nullptr_t) noexcept { clear(); return *this; }
+    template<typename F,
+             typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, UniqueFunction>
+                                         && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>>>
+    UniqueFunction& operator=(F&& f) { clear(); assign(std::forward<F>(f)); return *this; }
+
+    explicit operator bool() const noexcept { return m_ops; }
+    R operator()(Args... args) { return m_ops->invoke(m_storage, std::forward<Args>(args)...); }
+
+private:
+    struct Ops
+    {
+        R (*invoke)(void* storage, Args&&... args);
+        void (*move)(void* dst, void* src) noexcept;
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template<typename F> struct InlineOps
+    {
+        static R invoke(void* s, Args&&... args)
+        {
+            // Results are discarded when R is void, like std::function does.
+            if constexpr (std::is_void_v<R>)
+                std::invoke(*static_cast<F*>(s), std::forward<Args>(args)...);
+            else
+                return std::invoke(*static_cast<F*>(s), std::forward<Args>(args)...);
+        }
+        static void move(void* dst, void* src) noexcept { new (dst) F(std::move(*static_cast<F*>(src))); static_cast<F*>(src)->~F(); }
+        static void destroy(void* s) noexcept { static_cast<F*>(s)->~F(); }
+        static constexpr Ops ops = { &invoke, &move, &destroy };
+    };
+
+    template<typename F> struct HeapOps
+    {
+        static R invoke(void* s, Args&&... args)
+        {
+            if constexpr (std::is_void_v<R>)
+                std::invoke(**static_cast<F**>(s), std::forward<Args>(args)...);
+            else
+                return std::invoke(**static_cast<F**>(s), std::forward<Args>(args)...);
+        }
+        static void move(void* dst, void* src) noexcept { *static_cast<F**>(dst) = *static_cast<F**>(src); }
+        static void destroy(void* s) noexcept { delete *static_cast<F**>(s); }
+        static constexpr Ops ops = { &invoke, &move, &destroy };
+    };
+
+    template<typename T> struct IsStdFunction : std::false_type {};
+    template<typename T> struct IsStdFunction<std::function<T>> : std::true_type {};
+
+    template<typename F> void assign(F&& f);
+    void moveFrom(UniqueFunction& other) noexcept;
+    void clear() noexcept;
+
+private:
+    alignas(std::max_align_t) unsigned char m_storage[Capacity < sizeof(void*) ? sizeof(void*) : Capacity];
+    const Ops* m_ops = nullptr;
+};
+
+template<typename R, typename... Args, size_t Capacity>
+UniqueFunction<R(Args...), Capacity>& UniqueFunction<R(Args...), Capacity>::operator=(UniqueFunction&& other) noexcept
+{
+    if (this != &other) {
+        clear();
+        moveFrom(other);
+    }
+    return *this;
+}
+
+template<typename R, typename... Args, size_t Capacity>
+template<typename F>
+void UniqueFunction<R(Args...), Capacity>::assign(F&& f)
+{
+    using T = std::decay_t<F>;
+    // Null function pointers and empty std::functions result in an empty object.
+    if constexpr (std::is_pointer_v<T> || std::is_member_pointer_v<T> || IsStdFunction<T>::value) {
+        if (!f)
+            return;
+    }
+
+    if constexpr (isInline<T>) {
+        new (m_storage) T(std::forward<F>(f));
+        m_ops = &InlineOps<T>::ops;
+    }
+    else {
+        *reinterpret_cast<T**>(m_storage) = new T(std::forward<F>(f));
+        m_ops = &HeapOps<T>::ops;
+    }
+}
+
+template<typename R, typename... Args, size_t Capacity>
+void UniqueFunction<R(Args...), Capacity>::moveFrom(UniqueFunction& other) noexcept
+{
+    if (!other.m_ops)
+        return;
+    other.m_ops->move(m_storage, other.m_storage);
+    m_ops = other.m_ops;
+    other.m_ops = nullptr;
+}
+
+template<typename R, typename... Args, size_t Capacity>
+void UniqueFunction<R(Args...), Capacity>::clear() noexcept
+{
+    if (!m_ops)
+        return;
+    m_ops->destroy(m_storage);
+    m_ops = nullptr;
+}
+
+} // namespace
+
+#endif // LQTUTILS_FUNCTION_H
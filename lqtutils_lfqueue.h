@@ -0,0 +1,493 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Luca Carlon
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef LQTUTILS_LFQUEUE_H
+#define LQTUTILS_LFQUEUE_H
+
+#include <QString>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QDeadlineTimer>
+
+#include <atomic>
+#include <memory>
+#include <optional>
+
+#include "lqtutils_perf.h"
+
+#ifndef LQT_LFQUEUE_SPIN_COUNT
+#define LQT_LFQUEUE_SPIN_COUNT 256
+#endif
+
+namespace lqt {
+
+/**
+ * @brief The EventCount class parks threads waiting for a condition that is
+ * published through atomics. Notifiers only take the mutex when someone is
+ * actually waiting, so the fast path costs a fence and a load. Waiters can
+ * spin for a while before parking, as the other side is often about to act.
+ */
+class EventCount
+{
+public:
+    EventCount() : m_waiters(0) {}
+
+    template<typename Pred>
+    bool wait(Pred ready, const QDeadlineTimer& deadline, int spins = 0);
+    void notifyOne();
+    void notifyAll();
+
+private:
+    std::atomic<int> m_waiters;
+    QMutex m_mutex;
+    QWaitCondition m_cond;
+};
+
+template<typename Pred>
+bool EventCount::wait(Pred ready, const QDeadlineTimer& deadline, int spins)
+{
+    for (int i = 0; i < spins; i++) {
+        if (ready())
+            return true;
+        LC_CPU_RELAX();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_waiters.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    bool ret = true;
+    while (!ready()) {
+        if (!m_cond.wait(&m_mutex, deadline)) {
+            ret = ready();
+            break;
+        }
+    }
+
+    m_waiters.fetch_sub(1, std::memory_order_relaxed);
+    return ret;
+}
+
+inline void EventCount::notifyOne()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_waiters.load(std::memory_order_relaxed) == 0)
+        return;
+
+    QMutexLocker locker(&m_mutex);
+    m_cond.wakeOne();
+}
+
+inline void EventCount::notifyAll()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    QMutexLocker locker(&m_mutex);
+    m_cond.wakeAll();
+}
+
+inline quint64 next_pow2(quint64 v)
+{
+    quint64 ret = 1;
+    while (ret < v)
+        ret <<= 1;
+    return ret;
+}
+
+/**
+ * @brief The SpscBlockingQueue class is a bounded queue for exactly one
+ * producer thread and one consumer thread. Items live in a power-of-two
+ * ring indexed by atomic counters, so enqueue and dequeue never lock unless
+ * the ring is full or empty and the caller has to wait. Timeouts and dispose
+ * behave like in lqt::BlockingQueue. The capacity is rounded up to the next
+ * power of two.
+ */
+template<typename T>
+class SpscBlockingQueue
+{
+public:
+    SpscBlockingQueue(int capacity, const QString& name = QString());
+    bool enqueue(const T& e, qint64 timeout = -1) { return push(e, timeout); }
+    bool enqueue(T&& e, qint64 timeout = -1) { return push(std::move(e), timeout); }
+    bool tryEnqueue(const T& e) { return tryPush(e); }
+    bool tryEnqueue(T&& e) { return tryPush(std::move(e)); }
+    std::optional<T> dequeue(qint64 timeout = -1);
+    std::optional<T> tryDequeue();
+    std::optional<T> peek(qint64 timeout = -1);
+    int size() const;
+    int capacity() const { return static_cast<int>(m_mask + 1); }
+    bool isEmpty() const { return size() == 0; }
+    bool isDisposed() const { return m_disposed.load(std::memory_order_acquire); }
+    void requestDispose();
+    QString name() const { return m_name; }
+
+private:
+    template<typename U> bool push(U&& e, qint64 timeout);
+    template<typename U> bool tryPush(U&& e);
+    bool waitNotEmpty(const QDeadlineTimer& deadline);
+
+private:
+    // Consumer side.
+    alignas(LC_CACHE_LINE_SIZE) std::atomic<quint64> m_head;
+    quint64 m_cachedTail;
+    // Producer side.
+    alignas(LC_CACHE_LINE_SIZE) std::atomic<quint64> m_tail;
+    quint64 m_cachedHead;
+
+    alignas(LC_CACHE_LINE_SIZE) std::atomic<bool> m_disposed;
+    const quint64 m_mask;
+    std::unique_ptr<std::optional<T>[]> m_ring;
+    EventCount m_notEmpty;
+    EventCount m_notFull;
+    QString m_name;
+};
+
+template<typename T>
+SpscBlockingQueue<T>::SpscBlockingQueue(int capacity, const QString& name) :
+    m_head(0)
+  , m_cachedTail(0)
+  , m_tail(0)
+  , m_cachedHead(0)
+  , m_disposed(false)
+  , m_mask(next_pow2(qMax(capacity, 1)) - 1)
+  , m_ring(new std::optional<T>[m_mask + 1])
+  , m_name(name) {}
+
+template<typename T>
+template<typename U>
+bool SpscBlockingQueue<T>::tryPush(U&& e)
+{
+    const quint64 tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_cachedHead > m_mask) {
+        m_cachedHead = m_head.load(std::memory_order_acquire);
+        if (tail - m_cachedHead > m_mask)
+            return false;
+    }
+
+    m_ring[tail & m_mask].emplace(std::forward<U>(e));
+    m_tail.store(tail + 1, std::memory_order_release);
+    m_notEmpty.notifyOne();
+
+    return true;
+}
+
+template<typename T>
+template<typename U>
+bool SpscBlockingQueue<T>::push(U&& e, qint64 timeout)
+{
+    if (isDisposed())
+        return false;
+    if (tryPush(std::forward<U>(e)))
+        return true;
+    if (!timeout)
+        return false;
+
+    const QDeadlineTimer deadline(timeout);
+    while (true) {
+        const bool ready = m_notFull.wait([this] {
+            return isDisposed() ||
+                   m_tail.load(std::memory_order_relaxed) - m_head.load(std::memory_order_acquire) <= m_mask;
+        }, deadline, LQT_LFQUEUE_SPIN_COUNT);
+        if (!ready || isDisposed())
+            return false;
+        if (tryPush(std::forward<U>(e)))
+            return true;
+    }
+}
+
+template<typename T>
+std::optional<T> SpscBlockingQueue<T>::tryDequeue()
+{
+    const quint64 head = m_head.load(std::memory_order_relaxed);
+    if (head == m_cachedTail) {
+        m_cachedTail = m_tail.load(std::memory_order_acquire);
+        if (head == m_cachedTail)
+            return std::nullopt;
+    }
+
+    std::optional<T>& slot = m_ring[head & m_mask];
+    std::optional<T> ret(std::move(slot));
+    slot.reset();
+    m_head.store(head + 1, std::memory_order_release);
+    m_notFull.notifyOne();
+
+    return ret;
+}
+
+template<typename T>
+bool SpscBlockingQueue<T>::waitNotEmpty(const QDeadlineTimer& deadline)
+{
+    const bool ready = m_notEmpty.wait([this] {
+        return isDisposed() ||
+               m_tail.load(std::memory_order_acquire) != m_head.load(std::memory_order_relaxed);
+    }, deadline, LQT_LFQUEUE_SPIN_COUNT);
+    return ready && !isDisposed();
+}
+
+template<typename T>
+std::optional<T> SpscBlockingQueue<T>::dequeue(qint64 timeout)
+{
+    if (isDisposed())
+        return std::nullopt;
+
+    std::optional<T> ret = tryDequeue();
+    if (ret || !timeout)
+        return ret;
+
+    const QDeadlineTimer deadline(timeout);
+    while (!ret) {
+        if (!waitNotEmpty(deadline))
+            return std::nullopt;
+        ret = tryDequeue();
+    }
+
+    return ret;
+}
+
+template<typename T>
+std::optional<T> SpscBlockingQueue<T>::peek(qint64 timeout)
+{
+    if (isDisposed())
+        return std::nullopt;
+
+    const quint64 head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire)) {
+        if (!timeout || !waitNotEmpty(QDeadlineTimer(timeout)))
+            return std::nullopt;
+    }
+
+    return m_ring[head & m_mask];
+}
+
+template<typename T>
+int SpscBlockingQueue<T>::size() const
+{
+    const quint64 head = m_head.load(std::memory_order_acquire);
+    const quint64 tail = m_tail.load(std::memory_order_acquire);
+    return tail > head ? static_cast<int>(tail - head) : 0;
+}
+
+template<typename T>
+void SpscBlockingQueue<T>::requestDispose()
+{
+    m_disposed.store(true, std::memory_order_seq_cst);
+    m_notEmpty.notifyAll();
+    m_notFull.notifyAll();
+}
+
+/**
+ * @brief The MpmcBlockingQueue class is a bounded queue for any number of
+ * producers and consumers. Each slot of the ring carries a sequence number
+ * telling whether it can be written or read, so threads only compete on a CAS
+ * of the enqueue or dequeue position. When the queue is full or empty, callers
+ * spin for a short while and then park until the other side makes progress.
+ * Timeouts and dispose behave like in lqt::BlockingQueue. The capacity is
+ * rounded up to the next power of two.
+ */
+template<typename T>
+class MpmcBlockingQueue
+{
+public:
+    MpmcBlockingQueue(int capacity, const QString& name = QString());
+    bool enqueue(const T& e, qint64 timeout = -1) { return push(e, timeout); }
+    bool enqueue(T&& e, qint64 timeout = -1) { return push(std::move(e), timeout); }
+    bool tryEnqueue(const T& e) { return tryPush(e); }
+    bool tryEnqueue(T&& e) { return tryPush(std::move(e)); }
+    std::optional<T> dequeue(qint64 timeout = -1);
+    std::optional<T> tryDequeue();
+    int size() const;
+    int capacity() const { return static_cast<int>(m_mask + 1); }
+    bool isEmpty() const { return size() == 0; }
+    bool isDisposed() const { return m_disposed.load(std::memory_order_acquire); }
+    void requestDispose();
+    QString name() const { return m_name; }
+
+private:
+    struct Cell
+    {
+        std::atomic<quint64> seq;
+        std::optional<T> data;
+    };
+
+    template<typename U> bool push(U&& e, qint64 timeout);
+    template<typename U> bool tryPush(U&& e);
+    bool canPush() const;
+    bool canPop() const;
+
+private:
+    alignas(LC_CACHE_LINE_SIZE) std::atomic<quint64> m_enqueuePos;
+    alignas(LC_CACHE_LINE_SIZE) std::atomic<quint64> m_dequeuePos;
+    alignas(LC_CACHE_LINE_SIZE) std::atomic<bool> m_disposed;
+    const quint64 m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+    EventCount m_notEmpty;
+    EventCount m_notFull;
+    QString m_name;
+};
+
+template<typename T>
+MpmcBlockingQueue<T>::MpmcBlockingQueue(int capacity, const QString& name) :
+    m_enqueuePos(0)
+  , m_dequeuePos(0)
+  , m_disposed(false)
+  , m_mask(next_pow2(qMax(capacity, 1)) - 1)
+  , m_cells(new Cell[m_mask + 1])
+  , m_name(name)
+{
+    for (quint64 i = 0; i <= m_mask; i++)
+        m_cells[i].seq.store(i, std::memory_order_relaxed);
+}
+
+template<typename T>
+template<typename U>
+bool MpmcBlockingQueue<T>::tryPush(U&& e)
+{
+    Cell* cell;
+    quint64 pos = m_enqueuePos.load(std::memory_order_relaxed);
+    while (true) {
+        cell = &m_cells[pos & m_mask];
+        const quint64 seq = cell->seq.load(std::memory_order_acquire);
+        const qint64 diff = static_cast<qint64>(seq - pos);
+        if (diff == 0) {
+            if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+            return false;
+        else
+            pos = m_enqueuePos.load(std::memory_order_relaxed);
+    }
+
+    cell->data.emplace(std::forward<U>(e));
+    cell->seq.store(pos + 1, std::memory_order_release);
+    m_notEmpty.notifyOne();
+
+    return true;
+}
+
+template<typename T>
+std::optional<T> MpmcBlockingQueue<T>::tryDequeue()
+{
+    Cell* cell;
+    quint64 pos = m_dequeuePos.load(std::memory_order_relaxed);
+    while (true) {
+        cell = &m_cells[pos & m_mask];
+        const quint64 seq = cell->seq.load(std::memory_order_acquire);
+        const qint64 diff = static_cast<qint64>(seq - (pos + 1));
+        if (diff == 0) {
+            if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+            return std::nullopt;
+        else
+            pos = m_dequeuePos.load(std::memory_order_relaxed);
+    }
+
+    std::optional<T> ret(std::move(cell->data));
+    cell->data.reset();
+    cell->seq.store(pos + m_mask + 1, std::memory_order_release);
+    m_notFull.notifyOne();
+
+    return ret;
+}
+
+template<typename T>
+bool MpmcBlockingQueue<T>::canPush() const
+{
+    const quint64 pos = m_enqueuePos.load(std::memory_order_relaxed);
+    return m_cells[pos & m_mask].seq.load(std::memory_order_acquire) == pos;
+}
+
+template<typename T>
+bool MpmcBlockingQueue<T>::canPop() const
+{
+    const quint64 pos = m_dequeuePos.load(std::memory_order_relaxed);
+    return m_cells[pos & m_mask].seq.load(std::memory_order_acquire) == pos + 1;
+}
+
+template<typename T>
+template<typename U>
+bool MpmcBlockingQueue<T>::push(U&& e, qint64 timeout)
+{
+    if (isDisposed())
+        return false;
+    if (tryPush(std::forward<U>(e)))
+        return true;
+    if (!timeout)
+        return false;
+
+    const QDeadlineTimer deadline(timeout);
+    while (true) {
+        const bool ready = m_notFull.wait([this] {
+            return isDisposed() || canPush();
+        }, deadline, LQT_LFQUEUE_SPIN_COUNT);
+        if (!ready || isDisposed())
+            return false;
+        if (tryPush(std::forward<U>(e)))
+            return true;
+    }
+}
+
+template<typename T>
+std::optional<T> MpmcBlockingQueue<T>::dequeue(qint64 timeout)
+{
+    if (isDisposed())
+        return std::nullopt;
+
+    std::optional<T> ret = tryDequeue();
+    if (ret || !timeout)
+        return ret;
+
+    const QDeadlineTimer deadline(timeout);
+    while (!ret) {
+        const bool ready = m_notEmpty.wait([this] {
+            return isDisposed() || canPop();
+        }, deadline, LQT_LFQUEUE_SPIN_COUNT);
+        if (!ready || isDisposed())
+            return std::nullopt;
+        ret = tryDequeue();
+    }
+
+    return ret;
+}
+
+template<typename T>
+int MpmcBlockingQueue<T>::size() const
+{
+    const quint64 head = m_dequeuePos.load(std::memory_order_acquire);
+    const quint64 tail = m_enqueuePos.load(std::memory_order_acquire);
+    return tail > head ? static_cast<int>(qMin(tail - head, m_mask + 1)) : 0;
+}
+
+template<typename T>
+void MpmcBlockingQueue<T>::requestDispose()
+{
+    m_disposed.store(true, std::memory_order_seq_cst);
+    m_notEmpty.notifyAll();
+    m_notFull.notifyAll();
+}
+
+} // namespace
+
+#endif // LQTUTILS_LFQUEUE_H
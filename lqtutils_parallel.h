@@ -0,0 +1,233 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Luca Carlon
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef LQTUTILS_PARALLEL_H
+#define LQTUTILS_PARALLEL_H
+
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include "lqtutils_executor.h"
+
+namespace lqt {
+
+/**
+ * @brief The ParallelOptions struct configures the parallel algorithms.
+ */
+struct ParallelOptions
+{
+    // Number of elements per chunk, 0 to choose it from the size of the range
+    // and the number of workers.
+    qsizetype grainSize = 0;
+    // Executor running the chunks, nullptr for Executor::globalInstance().
+    Executor* executor = nullptr;
+    // When set to true, chunks not started yet are skipped.
+    const std::atomic<bool>* cancel = nullptr;
+};
+
+/**
+ * Splits [0, count) in chunks and calls f(begin, end) for each of them in the
+ * workers of the executor. The calling thread processes chunks too. Chunk
+ * boundaries are multiples of align, so chunks writing adjacent elements of
+ * the same array do not share cache lines.
+ *
+ * @brief parallel_for_chunks
+ * @param count
+ * @param f
+ * @param options
+ * @param align
+ * @return false if canceled.
+ */
+template<typename F>
+bool parallel_for_chunks(qsizetype count, F&& f, const ParallelOptions& options = ParallelOptions(), qsizetype align = 1)
+{
+    if (count <= 0)
+        return true;
+
+    Executor* executor = options.executor ? options.executor : Executor::globalInstance();
+    align = qMax<qsizetype>(1, align);
+    qsizetype grain = options.grainSize;
+    if (grain <= 0) {
+        // A few chunks per worker balance the load without much overhead.
+        const qsizetype chunks = qsizetype(executor->threadCount())*4;
+        grain = (count + chunks - 1)/chunks;
+    }
+    grain = (qMax<qsizetype>(1, grain) + align - 1)/align*align;
+    const qsizetype chunks = (count + grain - 1)/grain;
+
+    struct State
+    {
+        std::atomic<qsizetype> next { 0 };
+        std::atomic<qsizetype> done { 0 };
+        std::atomic<bool> canceled { false };
+        QMutex mutex;
+        QWaitCondition finished;
+    };
+    std::shared_ptr<State> state = std::make_shared<State>();
+
+    // Helpers starting late find no chunk left and never touch f or options.
+    auto process = [state, count, grain, chunks, &f, &options] {
+        qsizetype i;
+        while ((i = state->next.fetch_add(1, std::memory_order_relaxed)) < chunks) {
+            if (options.cancel && options.cancel->load(std::memory_order_relaxed))
+                state->canceled.store(true, std::memory_order_relaxed);
+            if (!state->canceled.load(std::memory_order_relaxed))
+                f(i*grain, qMin(count, (i + 1)*grain));
+            if (state->done.fetch_add(1, std::memory_order_acq_rel) + 1 == chunks) {
+                QMutexLocker locker(&state->mutex);
+                state->finished.wakeAll();
+            }
+        }
+    };
+
+    const qsizetype helpers = qMin<qsizetype>(executor->threadCount(), chunks - 1);
+    for (qsizetype i = 0; i < helpers; i++)
+        executor->post(process);
+    process();
+
+    QMutexLocker locker(&state->mutex);
+    while (state->done.load(std::memory_order_acquire) < chunks)
+        state->finished.wait(&state->mutex);
+
+    return !state->canceled.load(std::memory_order_relaxed);
+}
+
+/**
+ * Calls f(i) for each i in [begin, end) in parallel.
+ *
+ * @brief parallel_for
+ * @param begin
+ * @param end
+ * @param f
+ * @param options
+ * @return false if canceled.
+ */
+template<typename F>
+bool parallel_for(qsizetype begin, qsizetype end, F&& f, const ParallelOptions& options = ParallelOptions())
+{
+    return parallel_for_chunks(end - begin, [begin, &f] (qsizetype from, qsizetype to) {
+        for (qsizetype i = from; i < to; i++)
+            f(begin + i);
+    }, options);
+}
+
+/**
+ * Returns a vector with f applied to each element of container, computed in
+ * parallel. The container must provide random access iterators. If canceled,
+ * the elements not computed are default constructed and completed is set to
+ * false.
+ *
+ * @brief parallel_transform
+ * @param container
+ * @param f
+ * @param options
+ * @param completed
+ * @return
+ */
+template<typename Container, typename F>
+auto parallel_transform(const Container& container, F&& f, const ParallelOptions& options = ParallelOptions(),
+                        bool* completed = nullptr)
+{
+    using R = std::decay_t<std::invoke_result_t<F&, decltype(*std::cbegin(container))>>;
+    const auto first = std::cbegin(container);
+    const qsizetype count = qsizetype(std::distance(first, std::cend(container)));
+
+    QVector<R> ret(count);
+    R* out = ret.data();
+    const bool done = parallel_for_chunks(count, [first, out, &f] (qsizetype from, qsizetype to) {
+        for (qsizetype i = from; i < to; i++)
+            out[i] = f(first[i]);
+    }, options, qMax<qsizetype>(1, qsizetype(LC_CACHE_LINE_SIZE/sizeof(R))));
+    if (completed)
+        *completed = done;
+
+    return ret;
+}
+
+/**
+ * Maps each element of container with map and combines the results with
+ * reduce, starting from identity. Each chunk is reduced in parallel and the
+ * partial results are combined in order, so reduce only needs to be
+ * associative. identity is used as the initial value of each chunk. If
+ * canceled, only the chunks already processed are combined and completed is
+ * set to false.
+ *
+ * @brief parallel_reduce
+ * @param container
+ * @param identity
+ * @param map
+ * @param reduce
+ * @param options
+ * @param completed
+ * @return
+ */
+template<typename Container, typename T, typename Map, typename Reduce>
+T parallel_reduce(const Container& container, T identity, Map&& map, Reduce&& reduce,
+                  const ParallelOptions& options = ParallelOptions(), bool* completed = nullptr)
+{
+    const auto first = std::cbegin(container);
+    const qsizetype count = qsizetype(std::distance(first, std::cend(container)));
+    if (completed)
+        *completed = true;
+    if (count <= 0)
+        return identity;
+
+    ParallelOptions chunkOptions = options;
+    if (chunkOptions.grainSize <= 0) {
+        const Executor* executor = options.executor ? options.executor : Executor::globalInstance();
+        const qsizetype chunks = qsizetype(executor->threadCount())*4;
+        chunkOptions.grainSize = (count + chunks - 1)/chunks;
+    }
+
+    const qsizetype grain = chunkOptions.grainSize;
+    std::vector<std::optional<T>> partials(size_t((count + grain - 1)/grain));
+    const bool done = parallel_for_chunks(count, [first, grain, &identity, &partials, &map, &reduce] (qsizetype from, qsizetype to) {
+        T partial = identity;
+        for (qsizetype i = from; i < to; i++)
+            partial = reduce(std::move(partial), map(first[i]));
+        partials[size_t(from/grain)] = std::move(partial);
+    }, chunkOptions);
+    if (completed)
+        *completed = done;
+
+    T ret = std::move(identity);
+    for (std::optional<T>& partial : partials) {
+        if (partial)
+            ret = reduce(std::move(ret), std::move(*partial));
+    }
+
+    return ret;
+}
+
+} // namespace
+
+#endif // LQTUTILS_PARALLEL_H
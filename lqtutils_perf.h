@@ -30,6 +30,9 @@
 
 #include <functional>
 #include <optional>
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
 
 #ifdef __GNUC__
 #define LC_LIKELY(x) \
@@ -41,37 +44,71 @@
 #define LC_UNLIKELY(x) (x)
 #endif // __GNUC__
 
+#ifndef LC_CACHE_LINE_SIZE
+#define LC_CACHE_LINE_SIZE 64
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define LC_CPU_RELAX() _mm_pause()
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LC_CPU_RELAX() __builtin_ia32_pause()
+#elif defined(__GNUC__) && (defined(__aarch64__) || defined(__arm__))
+#define LC_CPU_RELAX() __asm__ __volatile__("yield")
+#else
+#define LC_CPU_RELAX() do {} while (0)
+#endif
+
 namespace lqt {
 
 /**
- * @brief measure_time Measures time spent in lambda f.
+ * @brief measure_time Measures time spent in lambda f. The callables are
+ * forwarded without being wrapped, so no allocation is needed.
  * @param f The procedure to time.
  * @param callback The callback returning the result.
- * @return Time taken to compute f.
+ * @param disable Whether you want to disable the measurement.
+ * @return Result of f.
  */
-inline void measure_time(std::function<void()> f, std::function<void(const qint64&)> callback = nullptr, bool disable = false)
+template<typename F, typename C = std::nullptr_t, typename R = std::invoke_result_t<std::decay_t<F>&>>
+inline R measure_time(F&& f, C&& callback = nullptr, bool disable = false)
 {
     if (disable)
-        f();
-    else {
-        QElapsedTimer timer;
-        timer.start();
-        f();
+        return f();
 
-        qint64 time = timer.elapsed();
-        if (callback)
+    QElapsedTimer timer;
+    timer.start();
+    auto report = [&] {
+        if constexpr (!std::is_same_v<std::decay_t<C>, std::nullptr_t>) {
+            if constexpr (std::is_constructible_v<bool, std::decay_t<C>&>) {
+                if (!callback)
+                    return;
+            }
+            qint64 time = timer.elapsed();
             callback(time);
+        }
+    };
+
+    if constexpr (std::is_void_v<R>) {
+        f();
+        report();
+    }
+    else {
+        R res = f();
+        report();
+        return res;
     }
 }
 
 /**
- * @brief measure_time Measures time spent in lambda f.
+ * @brief measure_time Measures time spent in lambda f. Kept for callers
+ * specifying T explicitly, a std::function<void()> is handled by the
+ * forwarding overload.
  * @param f The procedure to time.
  * @param disable Whether you want to disable the measurement.
  * @param callback The callback returning the result.
  * @return Time taken to compute f and result of f.
  */
-template<typename T>
+template<typename T, typename = std::enable_if_t<!std::is_void_v<T>>>
 inline T measure_time(std::function<T()> f, std::function<void(const qint64&)> callback = nullptr, bool disable = false)
 {
     if (disable)
@@ -88,6 +125,82 @@ inline T measure_time(std::function<T()> f, std::function<void(const qint64&)> c
     }
 }
 
+/**
+ * @brief The LatencyHistogram class collects durations into power-of-two
+ * buckets. Adding a sample is O(1) and needs no allocation; percentiles are
+ * interpolated linearly inside the bucket.
+ */
+class LatencyHistogram
+{
+public:
+    LatencyHistogram() { reset(); }
+    void add(qint64 value);
+    qint64 percentile(double p) const;
+    qint64 count() const { return m_count; }
+    qint64 min() const { return m_min; }
+    qint64 max() const { return m_max; }
+    void reset();
+
+private:
+    static constexpr int BUCKETS = 64;
+    qint64 m_buckets[BUCKETS];
+    qint64 m_count;
+    qint64 m_min;
+    qint64 m_max;
+};
+
+inline void LatencyHistogram::add(qint64 value)
+{
+    value = qMax<qint64>(value, 0);
+#ifdef __GNUC__
+    const int bucket = value ? 64 - __builtin_clzll(static_cast<quint64>(value)) : 0;
+#else
+    int bucket = 0;
+    for (quint64 v = static_cast<quint64>(value); v; v >>= 1)
+        bucket++;
+#endif
+    m_buckets[qMin(bucket, BUCKETS - 1)]++;
+    m_min = m_count ? qMin(m_min, value) : value;
+    m_count++;
+    m_max = qMax(m_max, value);
+}
+
+/**
+ * @brief LatencyHistogram::percentile
+ * @param p Percentile in the range [0, 100].
+ * @return The approximated value of the percentile.
+ */
+inline qint64 LatencyHistogram::percentile(double p) const
+{
+    if (!m_count)
+        return 0;
+
+    const qint64 target = qMax<qint64>(1, static_cast<qint64>(p/100.*m_count + .5));
+    qint64 cumulative = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        if (cumulative + m_buckets[i] < target) {
+            cumulative += m_buckets[i];
+            continue;
+        }
+
+        if (i == 0)
+            return 0;
+        const qint64 low = qMax(m_min, qint64(1) << (i - 1));
+        const qint64 high = qMin(m_max, (qint64(1) << qMin(i, 62)) - 1);
+        return low + (high - low)*(target - cumulative)/m_buckets[i];
+    }
+
+    return m_max;
+}
+
+inline void LatencyHistogram::reset()
+{
+    std::fill(m_buckets, m_buckets + BUCKETS, 0);
+    m_count = 0;
+    m_min = 0;
+    m_max = 0;
+}
+
 } // namespace
 
 #endif // LQTUTILS_PERF_H
@@ -0,0 +1,438 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Luca Carlon
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef LQTUTILS_PIPELINE_H
+#define LQTUTILS_PIPELINE_H
+
+#include <QString>
+#include <QList>
+#include <QElapsedTimer>
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "lqtutils_bqueue.h"
+#include "lqtutils_function.h"
+
+namespace lqt {
+
+/**
+ * @brief The PipelineStageStats struct reports the activity of a pipeline
+ * stage. The stage with the highest utilization is the bottleneck.
+ */
+struct PipelineStageStats
+{
+    QString name;
+    int workers = 0;
+    qint64 processed = 0;
+    // Elements processed per second since the pipeline was started.
+    double throughput = 0;
+    // Fraction of the time the workers spent running the stage functor.
+    double utilization = 0;
+    // Statistics of the input queue of the stage.
+    QueueStats queue;
+};
+
+template<typename In> class Pipeline;
+template<typename In, typename Out> class PipelineBuilder;
+
+/**
+ * @brief The PipelineStage class is the type erased stage of a Pipeline.
+ */
+class PipelineStage
+{
+public:
+    virtual ~PipelineStage() = default;
+    virtual void start() = 0;
+    virtual void close() = 0;
+    virtual void requestDispose() = 0;
+    virtual void join() = 0;
+    virtual PipelineStageStats stats(qint64 elapsedNs) const = 0;
+};
+
+/**
+ * @brief The PipelineInput class is a stage receiving elements of type T. An
+ * empty optional in the queue marks the end of the stream for one worker.
+ */
+template<typename T>
+class PipelineInput : public PipelineStage
+{
+public:
+    PipelineInput(int capacity, const QString& name) : m_queue(capacity, name) {}
+    BlockingQueue<std::optional<T>>& queue() { return m_queue; }
+
+protected:
+    BlockingQueue<std::optional<T>> m_queue;
+};
+
+/**
+ * @brief The PipelineOutput class is a stage producing elements of type U.
+ */
+template<typename U>
+class PipelineOutput
+{
+public:
+    void setNext(PipelineInput<U>* next) { m_next = next; }
+
+protected:
+    PipelineInput<U>* m_next = nullptr;
+};
+
+template<>
+class PipelineOutput<void> {};
+
+/**
+ * @brief The PipelineStageImpl class runs f in workers threads for each
+ * element of its input queue and sends the results to the next stage. When
+ * the last worker receives the end of the stream, the next stage is closed,
+ * so the pipeline is drained in order.
+ */
+template<typename T, typename U>
+class PipelineStageImpl : public PipelineInput<T>, public PipelineOutput<U>
+{
+public:
+    template<typename F>
+    PipelineStageImpl(const QString& name, F&& f, int workers, int capacity) :
+        PipelineInput<T>(capacity, name)
+      , m_name(name)
+      , m_f(std::forward<F>(f))
+      , m_workers(qMax(1, workers))
+      , m_exited(0)
+      , m_processed(0)
+      , m_busyNs(0) { this->m_queue.setStatsEnabled(true); }
+
+    void start() override;
+    void close() override;
+    void requestDispose() override { this->m_queue.requestDispose(); }
+    void join() override;
+    PipelineStageStats stats(qint64 elapsedNs) const override;
+
+private:
+    void run();
+
+private:
+    const QString m_name;
+    UniqueFunction<U(T&)> m_f;
+    const int m_workers;
+    std::vector<std::thread> m_threads;
+    std::atomic<int> m_exited;
+    std::atomic<qint64> m_processed;
+    std::atomic<qint64> m_busyNs;
+};
+
+template<typename T, typename U>
+void PipelineStageImpl<T, U>::start()
+{
+    for (int i = 0; i < m_workers; i++)
+        m_threads.emplace_back([this] { run(); });
+}
+
+/**
+ * Queues one end of stream marker per worker, after the pending elements.
+ */
+template<typename T, typename U>
+void PipelineStageImpl<T, U>::close()
+{
+    for (int i = 0; i < m_workers; i++)
+        this->m_queue.enqueue(std::optional<T>());
+}
+
+template<typename T, typename U>
+void PipelineStageImpl<T, U>::join()
+{
+    for (std::thread& t : m_threads) {
+        if (t.joinable())
+            t.join();
+    }
+}
+
+template<typename T, typename U>
+PipelineStageStats PipelineStageImpl<T, U>::stats(qint64 elapsedNs) const
+{
+    PipelineStageStats ret;
+    ret.name = m_name;
+    ret.workers = m_workers;
+    ret.processed = m_processed.load(std::memory_order_relaxed);
+    ret.queue = this->m_queue.stats();
+    if (elapsedNs > 0) {
+        ret.throughput = double(ret.processed)*1E9/elapsedNs;
+        ret.utilization = double(m_busyNs.load(std::memory_order_relaxed))/(double(elapsedNs)*m_workers);
+    }
+    return ret;
+}
+
+template<typename T, typename U>
+void PipelineStageImpl<T, U>::run()
+{
+    QElapsedTimer timer;
+    while (std::optional<std::optional<T>> e = this->m_queue.dequeue()) {
+        if (!*e) {
+            if (m_exited.fetch_add(1, std::memory_order_acq_rel) + 1 != m_workers)
+                return;
+            if constexpr (!std::is_void_v<U>) {
+                if (this->m_next)
+                    this->m_next->close();
+            }
+            return;
+        }
+
+        timer.start();
+        if constexpr (std::is_void_v<U>) {
+            m_f(**e);
+            m_busyNs.fetch_add(timer.nsecsElapsed(), std::memory_order_relaxed);
+            m_processed.fetch_add(1, std::memory_order_relaxed);
+        }
+        else {
+            U out = m_f(**e);
+            m_busyNs.fetch_add(timer.nsecsElapsed(), std::memory_order_relaxed);
+            m_processed.fetch_add(1, std::memory_order_relaxed);
+            // Fails only if the pipeline is disposed.
+            if (this->m_next)
+                this->m_next->queue().enqueue(std::optional<U>(std::move(out)));
+        }
+    }
+}
+
+/**
+ * @brief The Pipeline class is a chain of stages connected by bounded
+ * queues, each stage running in its own worker threads. Elements pushed into
+ * the pipeline flow through the stages; with more than one worker the stage
+ * functor must be thread safe and the order of the elements is not preserved.
+ * close() lets the stages drain in order, requestDispose() stops them
+ * discarding the pending elements. Pipelines are created by PipelineBuilder.
+ */
+template<typename In>
+class Pipeline
+{
+public:
+    ~Pipeline();
+
+    bool push(const In& e, qint64 timeout = -1) { return push(In(e), timeout); }
+    bool push(In&& e, qint64 timeout = -1);
+    void close();
+    void waitForFinished();
+    void requestDispose();
+
+    QString name() const { return m_name; }
+    int stageCount() const { return int(m_stages.size()); }
+    QList<PipelineStageStats> stats() const;
+    int bottleneck() const;
+
+private:
+    Q_DISABLE_COPY(Pipeline)
+    template<typename, typename> friend class PipelineBuilder;
+    Pipeline(const QString& name, std::vector<std::unique_ptr<PipelineStage>> stages, PipelineInput<In>* input);
+
+private:
+    const QString m_name;
+    std::vector<std::unique_ptr<PipelineStage>> m_stages;
+    PipelineInput<In>* m_input;
+    std::atomic<bool> m_closed;
+    QElapsedTimer m_clock;
+};
+
+template<typename In>
+Pipeline<In>::Pipeline(const QString& name, std::vector<std::unique_ptr<PipelineStage>> stages, PipelineInput<In>* input) :
+    m_name(name)
+  , m_stages(std::move(stages))
+  , m_input(input)
+  , m_closed(false)
+{
+    m_clock.start();
+    for (std::unique_ptr<PipelineStage>& stage : m_stages)
+        stage->start();
+}
+
+/**
+ * Sends e to the first stage, waiting up to timeout ms for free space. Returns
+ * false if the pipeline was closed or disposed. Must not be called
+ * concurrently with close().
+ *
+ * @brief Pipeline::push
+ * @param e
+ * @param timeout
+ * @return
+ */
+template<typename In>
+bool Pipeline<In>::push(In&& e, qint64 timeout)
+{
+    if (m_closed.load(std::memory_order_relaxed))
+        return false;
+    return m_input->queue().enqueue(std::optional<In>(std::move(e)), timeout);
+}
+
+/**
+ * Closes the pipeline and waits for the pending elements to be processed.
+ */
+template<typename In>
+Pipeline<In>::~Pipeline()
+{
+    close();
+    waitForFinished();
+}
+
+/**
+ * Stops accepting elements. The stages process the pending elements and
+ * finish one after the other.
+ *
+ * @brief Pipeline::close
+ */
+template<typename In>
+void Pipeline<In>::close()
+{
+    if (!m_closed.exchange(true))
+        m_stages.front()->close();
+}
+
+/**
+ * Waits for all the workers to finish, after close() or requestDispose().
+ *
+ * @brief Pipeline::waitForFinished
+ */
+template<typename In>
+void Pipeline<In>::waitForFinished()
+{
+    for (std::unique_ptr<PipelineStage>& stage : m_stages)
+        stage->join();
+}
+
+/**
+ * Disposes the queues from the first stage to the last one. The pending
+ * elements are discarded.
+ *
+ * @brief Pipeline::requestDispose
+ */
+template<typename In>
+void Pipeline<In>::requestDispose()
+{
+    m_closed.store(true);
+    for (std::unique_ptr<PipelineStage>& stage : m_stages)
+        stage->requestDispose();
+}
+
+template<typename In>
+QList<PipelineStageStats> Pipeline<In>::stats() const
+{
+    const qint64 elapsedNs = m_clock.nsecsElapsed();
+    QList<PipelineStageStats> ret;
+    for (const std::unique_ptr<PipelineStage>& stage : m_stages)
+        ret.append(stage->stats(elapsedNs));
+    return ret;
+}
+
+/**
+ * Returns the index of the stage with the highest utilization.
+ *
+ * @brief Pipeline::bottleneck
+ * @return
+ */
+template<typename In>
+int Pipeline<In>::bottleneck() const
+{
+    const QList<PipelineStageStats> s = stats();
+    int ret = 0;
+    for (int i = 1; i < s.size(); i++) {
+        if (s[i].utilization > s[ret].utilization)
+            ret = i;
+    }
+    return ret;
+}
+
+/**
+ * @brief The PipelineBuilder class chains the stages of a Pipeline receiving
+ * elements of type In. Out is the type produced by the last stage, which must
+ * be void when the pipeline is built:
+ *
+ * auto pipeline = lqt::PipelineBuilder<QByteArray>("ingest")
+ *     .stage("decode", decode, 2)
+ *     .stage("write", write)
+ *     .build();
+ */
+template<typename In, typename Out = In>
+class PipelineBuilder
+{
+public:
+    explicit PipelineBuilder(const QString& name = QString()) : m_name(name) {}
+
+    template<typename F, typename U = std::invoke_result_t<std::decay_t<F>&, std::add_lvalue_reference_t<Out>>>
+    PipelineBuilder<In, U> stage(const QString& name, F&& f, int workers = 1, int capacity = 64) &&;
+    std::unique_ptr<Pipeline<In>> build() &&;
+
+private:
+    template<typename, typename> friend class PipelineBuilder;
+
+private:
+    QString m_name;
+    std::vector<std::unique_ptr<PipelineStage>> m_stages;
+    PipelineInput<In>* m_input = nullptr;
+    PipelineOutput<Out>* m_last = nullptr;
+};
+
+/**
+ * Adds a stage calling f for each element in workers threads. capacity is
+ * the size of the input queue of the stage.
+ *
+ * @brief PipelineBuilder::stage
+ * @param name
+ * @param f
+ * @param workers
+ * @param capacity
+ * @return
+ */
+template<typename In, typename Out>
+template<typename F, typename U>
+PipelineBuilder<In, U> PipelineBuilder<In, Out>::stage(const QString& name, F&& f, int workers, int capacity) &&
+{
+    static_assert(!std::is_void_v<Out>, "The last stage consumes the elements");
+
+    auto* s = new PipelineStageImpl<Out, U>(name, std::forward<F>(f), workers, capacity);
+    PipelineBuilder<In, U> ret(m_name);
+    ret.m_stages = std::move(m_stages);
+    ret.m_stages.emplace_back(s);
+    if constexpr (std::is_same_v<In, Out>)
+        ret.m_input = m_input ? m_input : s;
+    else
+        ret.m_input = m_input;
+    if (m_last)
+        m_last->setNext(s);
+    if constexpr (!std::is_void_v<U>)
+        ret.m_last = s;
+    return ret;
+}
+
+template<typename In, typename Out>
+std::unique_ptr<Pipeline<In>> PipelineBuilder<In, Out>::build() &&
+{
+    static_assert(std::is_void_v<Out>, "The last stage must consume the elements");
+    return std::unique_ptr<Pipeline<In>>(new Pipeline<In>(m_name, std::move(m_stages), m_input));
+}
+
+} // namespace
+
+#endif // LQTUTILS_PIPELINE_H
@@ -0,0 +1,145 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Luca Carlon
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#include <QSocketNotifier>
+#include <QMetaObject>
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+#ifdef Q_OS_LINUX
+#include <sys/eventfd.h>
+#endif
+
+#include "lqtutils_qconsumer.h"
+
+namespace lqt {
+
+QueueConsumer::QueueConsumer(QObject* parent) :
+    QObject(parent)
+  , m_batchSize(64)
+  , m_maxBatches(16)
+  , m_finished(false)
+  , m_pending(false)
+  , m_readFd(-1)
+  , m_writeFd(-1)
+  , m_notifier(nullptr)
+{
+#if defined(Q_OS_LINUX)
+    m_readFd = m_writeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#elif defined(Q_OS_UNIX)
+    int fds[2];
+    if (pipe(fds) == 0) {
+        for (int fd : fds) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+        m_readFd = fds[0];
+        m_writeFd = fds[1];
+    }
+#endif
+
+    if (m_readFd >= 0) {
+        m_notifier = new QSocketNotifier(m_readFd, QSocketNotifier::Read, this);
+        connect(m_notifier, &QSocketNotifier::activated,
+                this, &QueueConsumer::drain);
+    }
+}
+
+QueueConsumer::~QueueConsumer()
+{
+    // After this, producers can no longer call queueReady().
+    if (m_detach)
+        m_detach();
+
+    delete m_notifier;
+#ifdef Q_OS_UNIX
+    if (m_readFd >= 0)
+        close(m_readFd);
+    if (m_writeFd >= 0 && m_writeFd != m_readFd)
+        close(m_writeFd);
+#endif
+}
+
+/**
+ * Called by producers, with the queue locked, when the queue becomes non-empty
+ * or is disposed. Only wakes up the event loop of the consumer.
+ *
+ * @brief QueueConsumer::queueReady
+ */
+void QueueConsumer::queueReady()
+{
+    if (m_pending.exchange(true))
+        return;
+
+#ifdef Q_OS_UNIX
+    if (m_writeFd >= 0) {
+        const quint64 value = 1;
+        ssize_t ret;
+        do {
+            ret = write(m_writeFd, &value, m_writeFd == m_readFd ? sizeof(value) : 1);
+        } while (ret < 0 && errno == EINTR);
+        return;
+    }
+#endif
+
+    QMetaObject::invokeMethod(this, "drain", Qt::QueuedConnection);
+}
+
+void QueueConsumer::clearNotification()
+{
+#ifdef Q_OS_UNIX
+    if (m_readFd < 0)
+        return;
+
+    quint64 value;
+    while (read(m_readFd, &value, sizeof(value)) > 0) {}
+#endif
+}
+
+void QueueConsumer::drain()
+{
+    // Reset before draining: elements enqueued from now on notify again.
+    clearNotification();
+    m_pending.store(false);
+
+    int batches = 0;
+    while (batches < m_maxBatches && m_drain())
+        batches++;
+
+    if (batches >= m_maxBatches) {
+        // Leave room to other events and continue later.
+        queueReady();
+        return;
+    }
+
+    if (!m_finished && m_disposed()) {
+        m_finished = true;
+        emit finished();
+    }
+}
+
+} // namespace
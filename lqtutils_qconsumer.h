@@ -0,0 +1,104 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Luca Carlon
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef LQTUTILS_QCONSUMER_H
+#define LQTUTILS_QCONSUMER_H
+
+#include <QObject>
+#include <QList>
+
+#include <atomic>
+#include <functional>
+
+#include "lqtutils_bqueue.h"
+
+QT_FORWARD_DECLARE_CLASS(QSocketNotifier);
+
+namespace lqt {
+
+/**
+ * @brief The QueueConsumer class consumes a blocking queue from the event loop
+ * of the thread it lives in, without a dedicated thread and without polling.
+ * When the queue goes from empty to non-empty, producers signal an eventfd (a
+ * pipe on other unixes) watched by a QSocketNotifier, and the consumer drains
+ * the queue in batches of up to batchSize elements passed to the handler. At
+ * most maxBatches batches are handled per activation, so a busy queue cannot
+ * starve the other events. The queue must outlive the consumer and the handler
+ * must use deleteLater() to destroy it.
+ */
+class QueueConsumer : public QObject, public QueueObserver
+{
+    Q_OBJECT
+public:
+    template<typename Q, typename F>
+    QueueConsumer(Q* queue, F handler, int batchSize = 64, QObject* parent = nullptr) :
+        QueueConsumer(parent) {
+        m_batchSize = batchSize;
+        m_drain = [this, queue, handler] () mutable {
+            auto batch = queue->dequeueUpTo(m_batchSize, 0);
+            if (batch.isEmpty())
+                return false;
+            handler(std::move(batch));
+            return true;
+        };
+        m_disposed = [queue] { return queue->isDisposed(); };
+        m_detach = [this, queue] { queue->removeObserver(this); };
+        queue->addObserver(this);
+        // Elements may have been enqueued before the consumer was created.
+        queueReady();
+    }
+    ~QueueConsumer();
+
+    int batchSize() const { return m_batchSize; }
+    void setBatchSize(int batchSize) { m_batchSize = qMax(1, batchSize); }
+    int maxBatches() const { return m_maxBatches; }
+    void setMaxBatches(int maxBatches) { m_maxBatches = qMax(1, maxBatches); }
+    void queueReady() override;
+
+signals:
+    void finished();
+
+private slots:
+    void drain();
+
+private:
+    explicit QueueConsumer(QObject* parent);
+    void clearNotification();
+
+private:
+    std::function<bool()> m_drain;
+    std::function<bool()> m_disposed;
+    std::function<void()> m_detach;
+    int m_batchSize;
+    int m_maxBatches;
+    bool m_finished;
+    std::atomic<bool> m_pending;
+    int m_readFd;
+    int m_writeFd;
+    QSocketNotifier* m_notifier;
+};
+
+} // namespace
+
+#endif // LQTUTILS_QCONSUMER_H
@@ -0,0 +1,74 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Luca Carlon
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#include <QTimer>
+
+#include "lqtutils_qmonitor.h"
+
+namespace lqt {
+
+QueueMonitor::QueueMonitor(std::function<QueueStats()> source, int interval, QObject* parent) :
+    QObject(parent)
+  , m_source(source)
+{
+    m_timer = new QTimer(this);
+    connect(m_timer, &QTimer::timeout,
+            this, &QueueMonitor::refresh);
+    m_timer->setInterval(interval);
+    m_timer->start();
+    refresh();
+}
+
+int QueueMonitor::interval() const
+{
+    return m_timer->interval();
+}
+
+void QueueMonitor::setInterval(int interval)
+{
+    m_timer->setInterval(interval);
+}
+
+void QueueMonitor::refresh()
+{
+    if (!m_source)
+        return;
+
+    const QueueStats stats = m_source();
+    set_name(stats.name);
+    set_size(stats.size);
+    set_capacity(stats.capacity);
+    set_enqueued(stats.enqueued);
+    set_dequeued(stats.dequeued);
+    set_dropped(stats.dropped);
+    set_highWaterMark(stats.highWaterMark);
+    set_producerBlockedMs(stats.producerBlockedNs/1E6);
+    set_consumerBlockedMs(stats.consumerBlockedNs/1E6);
+    set_residenceP50Ms(stats.residenceP50Ns/1E6);
+    set_residenceP90Ms(stats.residenceP90Ns/1E6);
+    set_residenceP99Ms(stats.residenceP99Ns/1E6);
+    set_residenceMaxMs(stats.residenceMaxNs/1E6);
+}
+
+} // namespace
@@ -0,0 +1,82 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Luca Carlon
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef LQTUTILS_QMONITOR_H
+#define LQTUTILS_QMONITOR_H
+
+#include <QObject>
+#include <QString>
+
+#include <functional>
+
+#include "lqtutils_prop.h"
+#include "lqtutils_bqueue.h"
+
+QT_FORWARD_DECLARE_CLASS(QTimer);
+
+namespace lqt {
+
+/**
+ * @brief The QueueMonitor class periodically samples the statistics of a queue
+ * and exposes them as notifiable properties, so they can be charted in QML.
+ * Times are reported in milliseconds. The queue must outlive the monitor.
+ */
+class QueueMonitor : public QObject
+{
+    Q_OBJECT
+    L_RO_PROP_AS(QString, name)
+    L_RO_PROP_AS(int, size, 0)
+    L_RO_PROP_AS(int, capacity, 0)
+    L_RO_PROP_AS(qint64, enqueued, 0)
+    L_RO_PROP_AS(qint64, dequeued, 0)
+    L_RO_PROP_AS(qint64, dropped, 0)
+    L_RO_PROP_AS(int, highWaterMark, 0)
+    L_RO_PROP_AS(double, producerBlockedMs, 0)
+    L_RO_PROP_AS(double, consumerBlockedMs, 0)
+    L_RO_PROP_AS(double, residenceP50Ms, 0)
+    L_RO_PROP_AS(double, residenceP90Ms, 0)
+    L_RO_PROP_AS(double, residenceP99Ms, 0)
+    L_RO_PROP_AS(double, residenceMaxMs, 0)
+public:
+    explicit QueueMonitor(std::function<QueueStats()> source, int interval = 1000, QObject* parent = nullptr);
+    template<typename Q>
+    explicit QueueMonitor(Q* queue, int interval = 1000, QObject* parent = nullptr) :
+        QueueMonitor([queue] { return queue->stats(); }, interval, parent) {
+        queue->setStatsEnabled(true);
+    }
+
+    int interval() const;
+    void setInterval(int interval);
+
+public slots:
+    void refresh();
+
+private:
+    std::function<QueueStats()> m_source;
+    QTimer* m_timer;
+};
+
+} // namespace
+
+#endif // LQTUTILS_QMONITOR_H
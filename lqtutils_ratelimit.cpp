@@ -0,0 +1,152 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Luca Carlon
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#include <QTimer>
+
+#include <limits>
+
+#include "lqtutils_ratelimit.h"
+
+namespace lqt {
+
+SignalRateLimiter::SignalRateLimiter(Mode mode, int interval, QObject* parent) :
+    QObject(parent)
+  , m_mode(mode)
+  , m_interval(qMax(0, interval))
+  , m_lastEmit(std::numeric_limits<qint64>::min()/2)
+  , m_lastTrigger(0)
+  , m_dirty(false)
+  , m_armed(false)
+  , m_triggerCount(0)
+  , m_emitCount(0)
+{
+    m_clock.start();
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(m_interval < 20 ? Qt::PreciseTimer : Qt::CoarseTimer);
+    connect(m_timer, &QTimer::timeout,
+            this, &SignalRateLimiter::timeout);
+}
+
+/**
+ * Records a change. Thread-safe: while an emission is already scheduled, this
+ * only sets a flag.
+ *
+ * @brief SignalRateLimiter::trigger
+ */
+void SignalRateLimiter::trigger()
+{
+    m_triggerCount.fetch_add(1, std::memory_order_relaxed);
+    if (m_mode == Debounce)
+        m_lastTrigger.store(m_clock.elapsed(), std::memory_order_relaxed);
+    m_dirty.store(true);
+    if (!m_armed.exchange(true))
+        QMetaObject::invokeMethod(this, [this] { process(); }, Qt::QueuedConnection);
+}
+
+/**
+ * Emits triggered() immediately if a trigger is pending. Must be called in the
+ * thread of the limiter.
+ *
+ * @brief SignalRateLimiter::flush
+ */
+void SignalRateLimiter::flush()
+{
+    fire();
+}
+
+/**
+ * Discards the pending trigger, if any.
+ *
+ * @brief SignalRateLimiter::cancel
+ */
+void SignalRateLimiter::cancel()
+{
+    m_dirty.store(false, std::memory_order_relaxed);
+}
+
+void SignalRateLimiter::process()
+{
+    switch (m_mode) {
+    case Throttle: {
+        const qint64 elapsed = m_clock.elapsed() - m_lastEmit;
+        if (elapsed >= m_interval) {
+            fire();
+            m_timer->start(m_interval);
+        }
+        else
+            m_timer->start(int(m_interval - elapsed));
+        break;
+    }
+    case Debounce:
+        m_timer->start(m_interval);
+        break;
+    case Coalesce:
+        fire();
+        idle();
+        break;
+    }
+}
+
+void SignalRateLimiter::timeout()
+{
+    if (m_mode == Debounce) {
+        const qint64 quiet = m_clock.elapsed() - m_lastTrigger.load(std::memory_order_relaxed);
+        if (quiet < m_interval) {
+            m_timer->start(int(m_interval - quiet));
+            return;
+        }
+        fire();
+        idle();
+        return;
+    }
+
+    // Throttle: keep the timer running while triggers keep coming, so the
+    // last one is delivered at the end of the interval.
+    if (m_dirty.load(std::memory_order_acquire)) {
+        fire();
+        m_timer->start(m_interval);
+    }
+    else
+        idle();
+}
+
+void SignalRateLimiter::fire()
+{
+    if (!m_dirty.exchange(false, std::memory_order_acq_rel))
+        return;
+    m_emitCount.fetch_add(1, std::memory_order_relaxed);
+    m_lastEmit = m_clock.elapsed();
+    emit triggered();
+}
+
+void SignalRateLimiter::idle()
+{
+    m_armed.store(false);
+    // A trigger may have seen the limiter armed after the last check.
+    if (m_dirty.load() && !m_armed.exchange(true))
+        QMetaObject::invokeMethod(this, [this] { process(); }, Qt::QueuedConnection);
+}
+
+} // namespace
@@ -0,0 +1,301 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Luca Carlon
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef LQTUTILS_RATELIMIT_H
+#define LQTUTILS_RATELIMIT_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QMutex>
+
+#include <atomic>
+
+#include "lqtutils_prop.h"
+
+QT_FORWARD_DECLARE_CLASS(QTimer);
+
+namespace lqt {
+
+/**
+ * @brief The SignalRateLimiter class reduces a stream of trigger() calls to
+ * fewer triggered() signals, emitted in the thread of the limiter:
+ * - Throttle emits at most once every interval ms, the first trigger is
+ *   delivered as soon as the event loop runs and the last one is never lost;
+ * - Debounce emits once no trigger was received for interval ms;
+ * - Coalesce emits once per iteration of the event loop.
+ * trigger() can be called from any thread and posts at most one event to the
+ * thread of the limiter per emission, so it can be connected with
+ * Qt::DirectConnection to signals emitted at a high rate by worker threads.
+ */
+class SignalRateLimiter : public QObject
+{
+    Q_OBJECT
+public:
+    enum Mode {
+        Throttle,
+        Debounce,
+        Coalesce
+    };
+    Q_ENUM(Mode)
+
+    explicit SignalRateLimiter(Mode mode, int interval = 0, QObject* parent = nullptr);
+
+    Mode mode() const { return m_mode; }
+    int interval() const { return m_interval; }
+    bool isPending() const { return m_dirty.load(std::memory_order_relaxed); }
+    quint64 triggerCount() const { return m_triggerCount.load(std::memory_order_relaxed); }
+    quint64 emitCount() const { return m_emitCount.load(std::memory_order_relaxed); }
+
+    template<typename Context, typename Slot>
+    static SignalRateLimiter* create(Mode mode, int interval, Context* context, Slot&& slot);
+    template<typename Sender, typename Signal>
+    QMetaObject::Connection attach(const Sender* sender, Signal signal);
+
+public slots:
+    void trigger();
+    void flush();
+    void cancel();
+
+signals:
+    void triggered();
+
+private slots:
+    void process();
+    void timeout();
+
+private:
+    void fire();
+    void idle();
+
+private:
+    const Mode m_mode;
+    const int m_interval;
+    QTimer* m_timer;
+    QElapsedTimer m_clock;
+    qint64 m_lastEmit;
+    std::atomic<qint64> m_lastTrigger;
+    std::atomic<bool> m_dirty;
+    std::atomic<bool> m_armed;
+    std::atomic<quint64> m_triggerCount;
+    std::atomic<quint64> m_emitCount;
+};
+
+/**
+ * Creates a limiter child of context and connects its triggered() signal to
+ * slot. Must be called in the thread of context.
+ *
+ * @brief SignalRateLimiter::create
+ * @param mode
+ * @param interval
+ * @param context
+ * @param slot
+ * @return
+ */
+template<typename Context, typename Slot>
+SignalRateLimiter* SignalRateLimiter::create(Mode mode, int interval, Context* context, Slot&& slot)
+{
+    SignalRateLimiter* limiter = new SignalRateLimiter(mode, interval, context);
+    connect(limiter, &SignalRateLimiter::triggered, context, std::forward<Slot>(slot));
+    return limiter;
+}
+
+/**
+ * Calls trigger() each time sender emits signal, in the thread emitting it.
+ * The arguments of the signal are discarded: the receiver of triggered() is
+ * expected to read the latest state.
+ *
+ * @brief SignalRateLimiter::attach
+ * @param sender
+ * @param signal
+ * @return
+ */
+template<typename Sender, typename Signal>
+QMetaObject::Connection SignalRateLimiter::attach(const Sender* sender, Signal signal)
+{
+    return connect(sender, signal, this, &SignalRateLimiter::trigger, Qt::DirectConnection);
+}
+
+/**
+ * Creates a limiter with SignalRateLimiter::create() and attaches it to
+ * signal of sender. Must be called in the thread of context.
+ *
+ * @brief rate_limit
+ * @param mode
+ * @param interval
+ * @param sender
+ * @param signal
+ * @param context
+ * @param slot
+ * @return
+ */
+template<typename Sender, typename Signal, typename Context, typename Slot>
+SignalRateLimiter* rate_limit(SignalRateLimiter::Mode mode, int interval,
+                              const Sender* sender, Signal signal,
+                              const Context* context, Slot&& slot)
+{
+    SignalRateLimiter* limiter = SignalRateLimiter::create(mode, interval, const_cast<Context*>(context), std::forward<Slot>(slot));
+    limiter->attach(sender, signal);
+    return limiter;
+}
+
+template<typename Sender, typename Signal, typename Context, typename Slot>
+SignalRateLimiter* throttle(const Sender* sender, Signal signal, int interval, const Context* context, Slot&& slot)
+{
+    return rate_limit(SignalRateLimiter::Throttle, interval, sender, signal, context, std::forward<Slot>(slot));
+}
+
+template<typename Sender, typename Signal, typename Context, typename Slot>
+SignalRateLimiter* debounce(const Sender* sender, Signal signal, int interval, const Context* context, Slot&& slot)
+{
+    return rate_limit(SignalRateLimiter::Debounce, interval, sender, signal, context, std::forward<Slot>(slot));
+}
+
+template<typename Sender, typename Signal, typename Context, typename Slot>
+SignalRateLimiter* coalesce(const Sender* sender, Signal signal, const Context* context, Slot&& slot)
+{
+    return rate_limit(SignalRateLimiter::Coalesce, 0, sender, signal, context, std::forward<Slot>(slot));
+}
+
+} // namespace
+
+// Props with rate limited notifications
+// =====================================
+// The setter stores the value immediately, name##Changed is emitted through a
+// lqt::SignalRateLimiter, so bindings are evaluated at most once per interval
+// (throttled), after interval ms of quiet (debounced) or once per iteration of
+// the event loop (coalesced). The limiter is returned by name##Limiter().
+// The value is protected by a mutex, so the setter can be called from any
+// thread; name##Changed is always emitted in the thread of the object.
+#define L_RW_PROP_THROTTLED(...) \
+    EXPAND( L_PROP_GET_MACRO(__VA_ARGS__, L_RW_PROP_THROTTLED4, L_RW_PROP_THROTTLED3)(__VA_ARGS__) )
+#define L_RO_PROP_THROTTLED(...) \
+    EXPAND( L_PROP_GET_MACRO(__VA_ARGS__, L_RO_PROP_THROTTLED4, L_RO_PROP_THROTTLED3)(__VA_ARGS__) )
+#define L_RW_PROP_DEBOUNCED(...) \
+    EXPAND( L_PROP_GET_MACRO(__VA_ARGS__, L_RW_PROP_DEBOUNCED4, L_RW_PROP_DEBOUNCED3)(__VA_ARGS__) )
+#define L_RO_PROP_DEBOUNCED(...) \
+    EXPAND( L_PROP_GET_MACRO(__VA_ARGS__, L_RO_PROP_DEBOUNCED4, L_RO_PROP_DEBOUNCED3)(__VA_ARGS__) )
+#define L_RW_PROP_COALESCED(...) \
+    EXPAND( L_PROP_GET_MACRO(__VA_ARGS__, L_RW_PROP_COALESCED4, L_RW_PROP_COALESCED3, L_RW_PROP_COALESCED2)(__VA_ARGS__) )
+#define L_RO_PROP_COALESCED(...) \
+    EXPAND( L_PROP_GET_MACRO(__VA_ARGS__, L_RO_PROP_COALESCED4, L_RO_PROP_COALESCED3, L_RO_PROP_COALESCED2)(__VA_ARGS__) )
+
+#define _INT_DECL_L_RL_PROP(type, name, mode, interval)                    \
+    public:                                                                \
+        type name() const {                                                \
+            QMutexLocker locker(&m_##name##Mutex);                         \
+            return m_##name ;                                              \
+        }                                                                  \
+        lqt::SignalRateLimiter* name##Limiter() const {                    \
+            return m_##name##Limiter;                                      \
+        }                                                                  \
+    Q_SIGNALS:                                                             \
+        void name##Changed(LQTUTILS_DECLARE_SIGNAL(type, name));           \
+    private:                                                               \
+        mutable QMutex m_##name##Mutex;                                    \
+        lqt::SignalRateLimiter* const m_##name##Limiter =                  \
+            lqt::SignalRateLimiter::create(mode, interval, this, [this] {  \
+                emit name##Changed(LQTUTILS_EMIT_SIGNAL(name()));          \
+            });
+
+#define _INT_DECL_L_RL_SETTER(type, name)                                  \
+        void set_##name(type name) {                                       \
+            {                                                              \
+                QMutexLocker locker(&m_##name##Mutex);                     \
+                if (m_##name == name) return;                              \
+                m_##name = name;                                           \
+            }                                                              \
+            m_##name##Limiter->trigger();                                  \
+        }                                                                  \
+    private:
+
+// A read-write prop both in C++ and in QML
+#define L_RW_PROP_RL_(type, name, mode, interval)                          \
+    _INT_DECL_L_RL_PROP(type, name, mode, interval)                        \
+        Q_PROPERTY(type name READ name WRITE set_##name NOTIFY name##Changed) \
+    public Q_SLOTS:                                                        \
+    _INT_DECL_L_RL_SETTER(type, name)
+
+// A read-write prop from C++, but read-only from QML
+#define L_RO_PROP_RL_(type, name, mode, interval)                          \
+    _INT_DECL_L_RL_PROP(type, name, mode, interval)                        \
+        Q_PROPERTY(type name READ name NOTIFY name##Changed)               \
+    public:                                                                \
+    _INT_DECL_L_RL_SETTER(type, name)
+
+#define L_RW_PROP_THROTTLED4(type, name, interval, def)                    \
+    L_RW_PROP_RL_(type, name, lqt::SignalRateLimiter::Throttle, interval)  \
+    type m_##name = def;
+
+#define L_RW_PROP_THROTTLED3(type, name, interval)                         \
+    L_RW_PROP_RL_(type, name, lqt::SignalRateLimiter::Throttle, interval)  \
+    type m_##name;
+
+#define L_RO_PROP_THROTTLED4(type, name, interval, def)                    \
+    L_RO_PROP_RL_(type, name, lqt::SignalRateLimiter::Throttle, interval)  \
+    type m_##name = def;
+
+#define L_RO_PROP_THROTTLED3(type, name, interval)                         \
+    L_RO_PROP_RL_(type, name, lqt::SignalRateLimiter::Throttle, interval)  \
+    type m_##name;
+
+#define L_RW_PROP_DEBOUNCED4(type, name, interval, def)                    \
+    L_RW_PROP_RL_(type, name, lqt::SignalRateLimiter::Debounce, interval)  \
+    type m_##name = def;
+
+#define L_RW_PROP_DEBOUNCED3(type, name, interval)                         \
+    L_RW_PROP_RL_(type, name, lqt::SignalRateLimiter::Debounce, interval)  \
+    type m_##name;
+
+#define L_RO_PROP_DEBOUNCED4(type, name, interval, def)                    \
+    L_RO_PROP_RL_(type, name, lqt::SignalRateLimiter::Debounce, interval)  \
+    type m_##name = def;
+
+#define L_RO_PROP_DEBOUNCED3(type, name, interval)                         \
+    L_RO_PROP_RL_(type, name, lqt::SignalRateLimiter::Debounce, interval)  \
+    type m_##name;
+
+#define L_RW_PROP_COALESCED3(type, name, def)                              \
+    L_RW_PROP_RL_(type, name, lqt::SignalRateLimiter::Coalesce, 0)         \
+    type m_##name = def;
+
+#define L_RW_PROP_COALESCED2(type, name)                                   \
+    L_RW_PROP_RL_(type, name, lqt::SignalRateLimiter::Coalesce, 0)         \
+    type m_##name;
+
+#define L_RO_PROP_COALESCED3(type, name, def)                              \
+    L_RO_PROP_RL_(type, name, lqt::SignalRateLimiter::Coalesce, 0)         \
+    type m_##name = def;
+
+#define L_RO_PROP_COALESCED2(type, name)                                   \
+    L_RO_PROP_RL_(type, name, lqt::SignalRateLimiter::Coalesce, 0)         \
+    type m_##name;
+
+// Coalesced props have no interval: four arguments are reported as misuse.
+#define L_RW_PROP_COALESCED4(type, name, def, extra)                       \
+    static_assert(false, "L_RW_PROP_COALESCED takes a type, a name and an optional default value");
+
+#define L_RO_PROP_COALESCED4(type, name, def, extra)                       \
+    static_assert(false, "L_RO_PROP_COALESCED takes a type, a name and an optional default value");
+
+#endif // LQTUTILS_RATELIMIT_H
@@ -0,0 +1,348 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Luca Carlon
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef LQTUTILS_SPILLQUEUE_H
+#define LQTUTILS_SPILLQUEUE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QDataStream>
+#include <QDir>
+#include <QTemporaryFile>
+#include <QDebug>
+
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "lqtutils_bqueue.h"
+
+#ifndef LQT_SPILLQUEUE_SEGMENT_SIZE
+#define LQT_SPILLQUEUE_SEGMENT_SIZE (64*1024*1024)
+#endif
+
+namespace lqt {
+
+/**
+ * @brief The SpillStorage class is the storage of a SpillBlockingQueue. Up to
+ * memoryCapacity elements are kept in a ring in memory. The excess is
+ * serialized with the QDataStream operators of T into append-only,
+ * memory-mapped segment files and read back in order when the ring has room.
+ * An element fits when it can be kept in memory or spilled within
+ * maxSpillBytes (-1 means no limit) to a segment that could be created.
+ * Elements added without being checked, e.g. by BlockingQueue::lockQueue(),
+ * are spilled regardless of the limit and kept in memory, out of order, if
+ * spilling fails. Elements that cannot be deserialized are lost and reported
+ * by takeLost(). T must be default constructible, as spilled elements are
+ * deserialized into a default constructed one.
+ */
+template<typename T>
+class SpillStorage
+{
+    static_assert(std::is_default_constructible_v<T>, "spilled elements are read into a default constructed T");
+
+public:
+    SpillStorage(int memoryCapacity, const QString& spillPath, qint64 maxSpillBytes);
+
+    int size() const { return m_memory.size() + m_spilledCount; }
+    bool isEmpty() const { return m_memory.isEmpty() && m_spilledCount == 0; }
+    int memorySize() const { return m_memory.size(); }
+    int spilledCount() const { return m_spilledCount; }
+    qint64 spilledBytes() const { return m_spilledBytes; }
+    qint64 maxSpillBytes() const { return m_maxSpillBytes; }
+    void setSegmentSize(qint64 segmentSize) { m_segmentSize = qMax<qint64>(1, segmentSize); }
+    bool fits(const T& e, int capacity);
+    int takeLost() { return std::exchange(m_lost, 0); }
+
+    void reserve(int) {}
+    template<typename... Args> void emplaceBack(Args&&... args) { append(T(std::forward<Args>(args)...)); }
+    void append(const T& e) { push(e, false); }
+    void append(T&& e) { push(std::move(e), false); }
+    void appendChecked(const T& e) { push(e, true); }
+    void appendChecked(T&& e) { push(std::move(e), true); }
+    T takeFirst();
+    void removeFirst();
+    T& first() { return m_memory.first(); }
+    const T& first() const { return m_memory.first(); }
+
+private:
+    Q_DISABLE_COPY(SpillStorage)
+
+    struct Segment
+    {
+        std::unique_ptr<QTemporaryFile> file;
+        uchar* data;
+        qint64 size;
+        qint64 readPos;
+        qint64 writePos;
+    };
+
+    // Elements already on disk are older, so memory can only be used when
+    // nothing is spilled.
+    bool inMemory() const { return m_spilledCount == 0 && m_memory.size() < m_capacity; }
+    template<typename U> void push(U&& e, bool checked);
+    bool reserveSpill(qint64 recordSize, bool limited);
+    void spill(const QByteArray& record);
+    bool addSegment(qint64 minSize);
+    bool readSpilled(T& e);
+    void refill();
+
+private:
+    int m_capacity;
+    QString m_spillPath;
+    qint64 m_maxSpillBytes;
+    qint64 m_segmentSize;
+    RingBuffer<T> m_memory;
+    RingBuffer<Segment> m_segments;
+    int m_spilledCount;
+    qint64 m_spilledBytes;
+    // Elements that could not be deserialized.
+    int m_lost;
+    // The element last passed to fits(), serialized when it has to be spilled.
+    const T* m_checked;
+    QByteArray m_record;
+};
+
+template<typename T>
+SpillStorage<T>::SpillStorage(int memoryCapacity, const QString& spillPath, qint64 maxSpillBytes) :
+    m_capacity(qMax(1, memoryCapacity))
+  , m_spillPath(spillPath.isEmpty() ? QDir::tempPath() : spillPath)
+  , m_maxSpillBytes(maxSpillBytes)
+  , m_segmentSize(LQT_SPILLQUEUE_SEGMENT_SIZE)
+  , m_memory(qMin(m_capacity, LQT_BQUEUE_MAX_PREALLOC))
+  , m_spilledCount(0)
+  , m_spilledBytes(0)
+  , m_lost(0)
+  , m_checked(nullptr) {}
+
+/**
+ * Returns true if e can be kept in memory or spilled. In the latter case, the
+ * serialized element is kept for appendChecked() and a segment with room for
+ * it is created if needed.
+ *
+ * @brief SpillStorage::fits
+ * @param e
+ * @return
+ */
+template<typename T>
+bool SpillStorage<T>::fits(const T& e, int)
+{
+    m_checked = &e;
+    if (inMemory())
+        return true;
+
+    m_record.clear();
+    QDataStream stream(&m_record, QIODevice::WriteOnly);
+    stream << e;
+    return reserveSpill(qint64(sizeof(quint32)) + m_record.size(), true);
+}
+
+template<typename T>
+template<typename U>
+void SpillStorage<T>::push(U&& e, bool checked)
+{
+    if (inMemory()) {
+        m_memory.append(std::forward<U>(e));
+        return;
+    }
+
+    if (checked) {
+        Q_ASSERT(&e == m_checked);
+        spill(m_record);
+        return;
+    }
+
+    QByteArray record;
+    QDataStream stream(&record, QIODevice::WriteOnly);
+    stream << static_cast<const T&>(e);
+    if (reserveSpill(qint64(sizeof(quint32)) + record.size(), false))
+        spill(record);
+    else
+        m_memory.append(std::forward<U>(e));
+}
+
+template<typename T>
+T SpillStorage<T>::takeFirst()
+{
+    T ret(m_memory.takeFirst());
+    refill();
+    return ret;
+}
+
+template<typename T>
+void SpillStorage<T>::removeFirst()
+{
+    m_memory.removeFirst();
+    refill();
+}
+
+/**
+ * Checks the spill limit, when limited, and makes sure that the last segment
+ * has room for a record of recordSize bytes.
+ */
+template<typename T>
+bool SpillStorage<T>::reserveSpill(qint64 recordSize, bool limited)
+{
+    if (limited && m_maxSpillBytes >= 0 && m_spilledBytes + recordSize > m_maxSpillBytes)
+        return false;
+    if (!m_segments.isEmpty() && m_segments.last().writePos + recordSize <= m_segments.last().size)
+        return true;
+    return addSegment(recordSize);
+}
+
+/**
+ * Appends a serialized element to the last segment, which must have room for
+ * it.
+ */
+template<typename T>
+void SpillStorage<T>::spill(const QByteArray& record)
+{
+    Segment& segment = m_segments.last();
+    const quint32 length = quint32(record.size());
+    memcpy(segment.data + segment.writePos, &length, sizeof(length));
+    memcpy(segment.data + segment.writePos + sizeof(length), record.constData(), size_t(record.size()));
+    const qint64 recordSize = qint64(sizeof(length)) + record.size();
+    segment.writePos += recordSize;
+    m_spilledCount++;
+    m_spilledBytes += recordSize;
+}
+
+template<typename T>
+bool SpillStorage<T>::addSegment(qint64 minSize)
+{
+    Segment segment;
+    segment.file.reset(new QTemporaryFile(m_spillPath + QStringLiteral("/lqt-spill-XXXXXX.seg")));
+    segment.size = qMax(m_segmentSize, minSize);
+    segment.readPos = 0;
+    segment.writePos = 0;
+    if (!segment.file->open() || !segment.file->resize(segment.size))
+        return false;
+    segment.data = segment.file->map(0, segment.size);
+    if (!segment.data)
+        return false;
+
+    m_segments.append(std::move(segment));
+    return true;
+}
+
+/**
+ * Reads the oldest spilled element. Drained segments are removed, except the
+ * last one which is rewound and reused.
+ */
+template<typename T>
+bool SpillStorage<T>::readSpilled(T& e)
+{
+    Segment& segment = m_segments.first();
+    quint32 length;
+    memcpy(&length, segment.data + segment.readPos, sizeof(length));
+    const QByteArray record = QByteArray::fromRawData(
+        reinterpret_cast<const char*>(segment.data + segment.readPos + sizeof(length)), int(length));
+    QDataStream stream(record);
+    stream >> e;
+    const bool ok = stream.status() == QDataStream::Ok;
+
+    const qint64 recordSize = qint64(sizeof(length)) + length;
+    segment.readPos += recordSize;
+    m_spilledCount--;
+    m_spilledBytes -= recordSize;
+
+    if (segment.readPos == segment.writePos) {
+        if (m_segments.size() > 1)
+            m_segments.removeFirst();
+        else
+            segment.readPos = segment.writePos = 0;
+    }
+
+    return ok;
+}
+
+/**
+ * Moves spilled elements back to memory while there is room.
+ */
+template<typename T>
+void SpillStorage<T>::refill()
+{
+    while (m_spilledCount > 0 && m_memory.size() < m_capacity) {
+        T e;
+        if (readSpilled(e)) {
+            m_memory.append(std::move(e));
+        }
+        else {
+            qWarning() << "Failed to read spilled element";
+            m_lost++;
+        }
+    }
+}
+
+/**
+ * @brief The SpillBlockingQueue class is a FIFO blocking queue that keeps up to
+ * memoryCapacity elements in memory and spills the excess to disk instead of
+ * blocking producers. Spilled elements are serialized with their QDataStream
+ * operators into append-only, memory-mapped segment files and are read back in
+ * order as soon as the memory ring has room. Producers only wait when the
+ * spilled data would exceed maxSpillBytes (-1 means no limit) or when the
+ * segment file cannot be written. Segment files are temporary and are removed
+ * when no longer needed. The size includes the spilled elements, capacity()
+ * is the memory capacity. The rest of the API, including statistics and wait
+ * policies, is the one of BlockingQueue. Spilled elements that cannot be
+ * deserialized are discarded and counted as dropped in the statistics. T
+ * must be default constructible.
+ */
+template<typename T, typename WaitPolicy = BlockWaitPolicy>
+class SpillBlockingQueue : public BlockingQueue<T, SpillStorage<T>, WaitPolicy>
+{
+public:
+    typedef SpillStorage<T> Storage;
+
+    SpillBlockingQueue(int memoryCapacity,
+                       const QString& spillPath = QString(),
+                       qint64 maxSpillBytes = -1,
+                       const QString& name = QString()) :
+        BlockingQueue<T, Storage, WaitPolicy>(qMax(1, memoryCapacity), name, std::in_place,
+                                              memoryCapacity, spillPath, maxSpillBytes) {}
+
+    int memorySize() const { return this->withStorage([] (const Storage& storage) { return storage.memorySize(); }); }
+    int spilledCount() const { return this->withStorage([] (const Storage& storage) { return storage.spilledCount(); }); }
+    qint64 spilledBytes() const { return this->withStorage([] (const Storage& storage) { return storage.spilledBytes(); }); }
+    qint64 maxSpillBytes() const { return this->withStorage([] (const Storage& storage) { return storage.maxSpillBytes(); }); }
+    void setSegmentSize(qint64 segmentSize);
+};
+
+/**
+ * Sets the size of the segment files created from now on. Records larger than
+ * a segment get a segment of their own.
+ *
+ * @brief SpillBlockingQueue::setSegmentSize
+ * @param segmentSize
+ */
+template<typename T, typename WaitPolicy>
+void SpillBlockingQueue<T, WaitPolicy>::setSegmentSize(qint64 segmentSize)
+{
+    this->withStorage([segmentSize] (Storage& storage) { storage.setSegmentSize(segmentSize); });
+}
+
+}
+
+#endif // LQTUTILS_SPILLQUEUE_H
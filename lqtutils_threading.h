@@ -31,10 +31,37 @@
 #include <QTimer>
 #include <QEventLoop>
 #include <QSemaphore>
+#include <QHash>
+#include <QEvent>
+#include <QCoreApplication>
+#include <QFuture>
+#include <QFutureInterface>
+#include <QFutureWatcher>
+#include <QPointer>
+#include <QDeadlineTimer>
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
 #include <QRecursiveMutex>
 #endif
+#include <atomic>
+#include <deque>
 #include <functional>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include "lqtutils_function.h"
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define LQT_HAS_COROUTINES
+#include <coroutine>
+#include <exception>
+#include <stdexcept>
+#endif
+#endif
 
 #define INVOKE_AWAIT_ASYNC(obj, ...) {                                                                               \
         auto type = QThread::currentThread() == obj->thread() ? Qt::DirectConnection : Qt::BlockingQueuedConnection; \
@@ -43,6 +70,330 @@
 
 namespace lqt {
 
+/**
+ * @brief The ThreadDispatcher class runs callables in the event loop of a
+ * thread. A single dispatcher is created for each QThread the first time it is
+ * used and it is destroyed when the thread finishes, so a call only costs one
+ * posted event carrying the callable. Move-only callables are supported.
+ */
+class ThreadDispatcher : public QObject
+{
+public:
+    template<typename F> static void post(QThread* t, F&& f);
+
+protected:
+    bool event(QEvent* e) override;
+
+private:
+    class CallEvent : public QEvent
+    {
+    public:
+        CallEvent() : QEvent(eventType()) {}
+        virtual void call() = 0;
+        static QEvent::Type eventType() {
+            static const QEvent::Type type = static_cast<QEvent::Type>(QEvent::registerEventType());
+            return type;
+        }
+    };
+
+    template<typename F>
+    class FunctorEvent : public CallEvent
+    {
+    public:
+        template<typename U> explicit FunctorEvent(U&& f) : m_f(std::forward<U>(f)) {}
+        void call() override { m_f(); }
+    private:
+        F m_f;
+    };
+
+    static QMutex& registryMutex() { static QMutex mutex; return mutex; }
+    static QHash<QThread*, ThreadDispatcher*>& registry() { static QHash<QThread*, ThreadDispatcher*> dispatchers; return dispatchers; }
+    static ThreadDispatcher* dispatcher(QThread* t);
+    static ThreadDispatcher* unregister(QThread* t, ThreadDispatcher* d);
+};
+
+/**
+ * Runs f in the event loop of t.
+ *
+ * @brief ThreadDispatcher::post
+ * @param t
+ * @param f
+ */
+template<typename F>
+void ThreadDispatcher::post(QThread* t, F&& f)
+{
+    auto* e = new FunctorEvent<std::decay_t<F>>(std::forward<F>(f));
+    // Posting under the lock prevents the dispatcher from being released meanwhile.
+    QMutexLocker locker(&registryMutex());
+    QCoreApplication::postEvent(dispatcher(t), e);
+}
+
+inline bool ThreadDispatcher::event(QEvent* e)
+{
+    if (e->type() != CallEvent::eventType())
+        return QObject::event(e);
+
+    static_cast<CallEvent*>(e)->call();
+    return true;
+}
+
+/**
+ * Returns the dispatcher of t, creating it if needed. Must be called with the
+ * registry locked.
+ */
+inline ThreadDispatcher* ThreadDispatcher::dispatcher(QThread* t)
+{
+    ThreadDispatcher* d = registry().value(t);
+    if (d)
+        return d;
+
+    d = new ThreadDispatcher;
+    d->moveToThread(t);
+    registry().insert(t, d);
+
+    // Emitted by t right before its event loop is gone: pending deferred
+    // deletes are still processed.
+    connect(t, &QThread::finished, d, [t, d] {
+        if (unregister(t, d))
+            d->deleteLater();
+    }, Qt::DirectConnection);
+    // The thread may be destroyed without ever being started.
+    connect(t, &QObject::destroyed, d, [t, d] {
+        if (unregister(t, d))
+            delete d;
+    }, Qt::DirectConnection);
+
+    return d;
+}
+
+inline ThreadDispatcher* ThreadDispatcher::unregister(QThread* t, ThreadDispatcher* d)
+{
+    QMutexLocker locker(&registryMutex());
+    if (registry().value(t) != d)
+        return nullptr;
+    registry().remove(t);
+    return d;
+}
+
+/**
+ * @brief The DispatchBatcher class delivers many small callables to the same
+ * thread in a few events. Callables posted to a thread while a delivery is
+ * pending join the same batch and run in FIFO order. A batch is held for at
+ * most maxDelay ms, 0 meaning the next iteration of the target event loop,
+ * and delivered as soon as it reaches maxBatchSize callables. One event never
+ * runs more than maxBatchSize callables, so other events are not starved.
+ * Pending callables are delivered even if the batcher is destroyed first and
+ * destroyed without running if the target thread finishes first. Move-only
+ * callables are supported.
+ */
+class DispatchBatcher
+{
+public:
+    DispatchBatcher(int maxBatchSize = 256, int maxDelay = 0);
+
+    static DispatchBatcher* globalInstance();
+
+    template<typename F> void post(QThread* t, F&& f);
+    void flush();
+
+    int maxBatchSize() const { return m_state->maxBatchSize; }
+    int maxDelay() const { return m_state->maxDelay; }
+    qint64 batchCount() const { return m_state->batches.load(std::memory_order_relaxed); }
+    qint64 coalescedCount() const { return m_state->coalesced.load(std::memory_order_relaxed); }
+
+private:
+    struct Pending
+    {
+        std::deque<UniqueFunction<void()>> calls;
+        // A delivery is pending, possibly delayed by a timer.
+        bool scheduled = false;
+        // An immediate delivery is pending.
+        bool urgent = false;
+    };
+
+    struct State
+    {
+        QMutex mutex;
+        // QHash would need copyable values to detach.
+        std::unordered_map<QThread*, Pending> pending;
+        int maxBatchSize;
+        int maxDelay;
+        std::atomic<qint64> batches { 0 };
+        std::atomic<qint64> coalesced { 0 };
+    };
+
+    // Discards the calls of a thread if the delivery scheduled for them is
+    // destroyed without running, e.g. because the thread finished.
+    class DeliveryGuard
+    {
+    public:
+        DeliveryGuard(std::shared_ptr<State> state, QThread* t) : m_state(std::move(state)), m_thread(t) {}
+        DeliveryGuard(DeliveryGuard&& other) noexcept :
+            m_state(std::move(other.m_state)), m_thread(other.m_thread) {}
+        DeliveryGuard(const DeliveryGuard&) = delete;
+        DeliveryGuard& operator=(const DeliveryGuard&) = delete;
+        ~DeliveryGuard() { if (m_state) discard(m_state, m_thread); }
+
+        void deliver() { DispatchBatcher::deliver(std::exchange(m_state, nullptr), m_thread); }
+
+    private:
+        std::shared_ptr<State> m_state;
+        QThread* m_thread;
+    };
+
+    static void schedule(const std::shared_ptr<State>& state, QThread* t, QDeadlineTimer deadline);
+    static void deliver(const std::shared_ptr<State>& state, QThread* t);
+    static void discard(const std::shared_ptr<State>& state, QThread* t);
+
+private:
+    std::shared_ptr<State> m_state;
+};
+
+inline DispatchBatcher::DispatchBatcher(int maxBatchSize, int maxDelay) :
+    m_state(std::make_shared<State>())
+{
+    m_state->maxBatchSize = qMax(1, maxBatchSize);
+    m_state->maxDelay = qMax(0, maxDelay);
+}
+
+/**
+ * Returns a batcher shared by the process, delivering in the next iteration
+ * of the target event loop.
+ *
+ * @brief DispatchBatcher::globalInstance
+ * @return
+ */
+inline DispatchBatcher* DispatchBatcher::globalInstance()
+{
+    static DispatchBatcher batcher;
+    return &batcher;
+}
+
+/**
+ * Queues f to be run in the event loop of t.
+ *
+ * @brief DispatchBatcher::post
+ * @param t
+ * @param f
+ */
+template<typename F>
+void DispatchBatcher::post(QThread* t, F&& f)
+{
+    QMutexLocker locker(&m_state->mutex);
+    Pending& p = m_state->pending[t];
+    p.calls.emplace_back(std::forward<F>(f));
+    if (!p.scheduled) {
+        p.scheduled = true;
+        p.urgent = m_state->maxDelay <= 0;
+        locker.unlock();
+        schedule(m_state, t, QDeadlineTimer(m_state->maxDelay));
+    }
+    else if (!p.urgent && p.calls.size() >= size_t(m_state->maxBatchSize)) {
+        p.urgent = true;
+        locker.unlock();
+        schedule(m_state, t, QDeadlineTimer(0));
+    }
+}
+
+/**
+ * Delivers the pending callables of all the threads without waiting for
+ * their delay to expire.
+ *
+ * @brief DispatchBatcher::flush
+ */
+inline void DispatchBatcher::flush()
+{
+    QList<QThread*> threads;
+    {
+        QMutexLocker locker(&m_state->mutex);
+        for (auto it = m_state->pending.begin(); it != m_state->pending.end(); ++it) {
+            if (it->second.urgent)
+                continue;
+            it->second.urgent = true;
+            threads.append(it->first);
+        }
+    }
+
+    for (QThread* t : threads)
+        schedule(m_state, t, QDeadlineTimer(0));
+}
+
+inline void DispatchBatcher::schedule(const std::shared_ptr<State>& state, QThread* t, QDeadlineTimer deadline)
+{
+    ThreadDispatcher::post(t, [guard = DeliveryGuard(state, t), deadline] () mutable {
+        const qint64 remaining = deadline.remainingTime();
+        if (remaining <= 0) {
+            guard.deliver();
+            return;
+        }
+
+        // The timer is deleted when t finishes, so the guard is released
+        // even if the delay never expires.
+        auto* timer = new QTimer;
+        timer->setSingleShot(true);
+        auto shared = std::make_shared<DeliveryGuard>(std::move(guard));
+        QObject::connect(timer, &QTimer::timeout, timer, [shared, timer] {
+            shared->deliver();
+            timer->deleteLater();
+        });
+        QObject::connect(QThread::currentThread(), &QThread::finished,
+                         timer, &QObject::deleteLater, Qt::DirectConnection);
+        timer->start(int(remaining));
+    });
+}
+
+/**
+ * Runs the oldest batch of t. Must be called in t.
+ */
+inline void DispatchBatcher::deliver(const std::shared_ptr<State>& state, QThread* t)
+{
+    std::deque<UniqueFunction<void()>> batch;
+    {
+        QMutexLocker locker(&state->mutex);
+        auto it = state->pending.find(t);
+        // Several deliveries may be pending, an earlier one already took the calls.
+        if (it == state->pending.end())
+            return;
+
+        Pending& p = it->second;
+        if (p.calls.size() <= size_t(state->maxBatchSize)) {
+            batch.swap(p.calls);
+            state->pending.erase(it);
+        }
+        else {
+            const auto end = p.calls.begin() + state->maxBatchSize;
+            std::move(p.calls.begin(), end, std::back_inserter(batch));
+            p.calls.erase(p.calls.begin(), end);
+            // The remaining calls already waited, deliver them right after.
+            p.urgent = true;
+            locker.unlock();
+            schedule(state, t, QDeadlineTimer(0));
+        }
+    }
+
+    state->batches.fetch_add(1, std::memory_order_relaxed);
+    state->coalesced.fetch_add(qint64(batch.size()) - 1, std::memory_order_relaxed);
+    for (UniqueFunction<void()>& call : batch)
+        call();
+}
+
+/**
+ * Forgets the pending calls of t, which can no longer be delivered.
+ */
+inline void DispatchBatcher::discard(const std::shared_ptr<State>& state, QThread* t)
+{
+    Pending p;
+    {
+        QMutexLocker locker(&state->mutex);
+        auto it = state->pending.find(t);
+        if (it == state->pending.end())
+            return;
+        p = std::move(it->second);
+        state->pending.erase(it);
+    }
+    // The callables are destroyed unlocked, they may post again.
+}
+
 template<typename T> T run_in_thread_sync(QObject* o, std::function<T()> f)
 {
     QSemaphore sem;
@@ -59,11 +410,8 @@ template<typename T> T run_in_thread_sync(QThread* t, std::function<T()> f)
 {
     QSemaphore sem;
     T ret;
-    QObject* o = new QObject;
-    o->moveToThread(t);
-    QTimer::singleShot(0, o, [&f, o, &ret, &sem] {
+    ThreadDispatcher::post(t, [&f, &ret, &sem] {
         ret = f();
-        o->deleteLater();
         sem.release();
     });
     sem.acquire();
@@ -73,16 +421,75 @@ template<typename T> T run_in_thread_sync(QThread* t, std::function<T()> f)
 inline void run_in_thread_sync(QThread* t, std::function<void()> f)
 {
     QSemaphore sem;
-    QObject* o = new QObject;
-    o->moveToThread(t);
-    QTimer::singleShot(0, o, [&f, o, &sem] {
+    ThreadDispatcher::post(t, [&f, &sem] {
         f();
-        o->deleteLater();
         sem.release();
     });
     sem.acquire();
 }
 
+/**
+ * Runs f in the event loop of t and waits for its result. f is called by
+ * reference, so it is neither copied nor wrapped.
+ *
+ * @brief run_in_thread_sync
+ * @param t
+ * @param f
+ * @return The result of f.
+ */
+template<typename F, typename R = std::invoke_result_t<std::decay_t<F>&>>
+R run_in_thread_sync(QThread* t, F&& f)
+{
+    QSemaphore sem;
+    if constexpr (std::is_void_v<R>) {
+        ThreadDispatcher::post(t, [&f, &sem] {
+            f();
+            sem.release();
+        });
+        sem.acquire();
+    }
+    else {
+        std::optional<R> ret;
+        ThreadDispatcher::post(t, [&f, &ret, &sem] {
+            ret.emplace(f());
+            sem.release();
+        });
+        sem.acquire();
+        return std::move(*ret);
+    }
+}
+
+/**
+ * Runs f in the thread of o and waits for its result. f is called by
+ * reference, so it is neither copied nor wrapped.
+ *
+ * @brief run_in_thread_sync
+ * @param o
+ * @param f
+ * @return The result of f.
+ */
+template<typename F, typename R = std::invoke_result_t<std::decay_t<F>&>>
+R run_in_thread_sync(QObject* o, F&& f)
+{
+    QSemaphore sem;
+    if constexpr (std::is_void_v<R>) {
+        QTimer::singleShot(0, o, [&f, &sem] {
+            f();
+            sem.release();
+        });
+        sem.acquire();
+    }
+    else {
+        std::optional<R> ret;
+        QTimer::singleShot(0, o, [&f, &ret, &sem] {
+            ret.emplace(f());
+            sem.release();
+        });
+        sem.acquire();
+        return std::move(*ret);
+    }
+}
+
 inline void run_in_thread_sync(QObject* o, std::function<void()> f, QSemaphore* sem)
 {
     QTimer::singleShot(0, o, [&f, &sem] {
@@ -98,15 +505,395 @@ inline void run_in_thread_sync(QObject* o, std::function<void()> f)
     run_in_thread_sync(o, f, &sem);
 }
 
-inline void run_in_thread(QThread* t, std::function<void()> f)
+/**
+ * Runs f in the event loop of t without waiting for it. f is moved into the
+ * posted event, so no other allocation is needed.
+ *
+ * @brief run_in_thread
+ * @param t
+ * @param f
+ */
+template<typename F>
+void run_in_thread(QThread* t, F&& f)
 {
-    QObject* o = new QObject;
-    o->moveToThread(t);
-    QTimer::singleShot(0, o, [f, o] {
-        f();
-        o->deleteLater();
+    ThreadDispatcher::post(t, std::forward<F>(f));
+}
+
+/**
+ * @brief The PromiseGuard class holds a started QFutureInterface and reports
+ * it canceled and finished if it is destroyed before finish() is called, for
+ * instance when the event carrying it is discarded because the thread exited.
+ */
+template<typename T>
+class PromiseGuard
+{
+public:
+    explicit PromiseGuard(const QFutureInterface<T>& promise) : m_promise(promise), m_armed(true) {}
+    PromiseGuard(PromiseGuard&& other) : m_promise(other.m_promise), m_armed(std::exchange(other.m_armed, false)) {}
+    PromiseGuard(const PromiseGuard&) = delete;
+    PromiseGuard& operator=(const PromiseGuard&) = delete;
+    ~PromiseGuard() {
+        if (!m_armed)
+            return;
+        m_promise.reportCanceled();
+        m_promise.reportFinished();
+    }
+
+    QFutureInterface<T>& promise() { return m_promise; }
+    void finish() {
+        m_armed = false;
+        m_promise.reportFinished();
+    }
+
+private:
+    QFutureInterface<T> m_promise;
+    bool m_armed;
+};
+
+/**
+ * Runs f in the event loop of t without waiting for it. The future is
+ * canceled if the event is discarded before f runs.
+ *
+ * @brief run_in_thread_async
+ * @param t
+ * @param f
+ * @return A future reporting the result of f.
+ */
+template<typename F, typename T = std::invoke_result_t<std::decay_t<F>&>>
+QFuture<T> run_in_thread_async(QThread* t, F&& f)
+{
+    QFutureInterface<T> promise;
+    promise.reportStarted();
+    QFuture<T> future = promise.future();
+    ThreadDispatcher::post(t, [guard = PromiseGuard<T>(promise), f = std::forward<F>(f)] () mutable {
+        if constexpr (std::is_void_v<T>)
+            f();
+        else
+            guard.promise().reportResult(f());
+        guard.finish();
+    });
+    return future;
+}
+
+/**
+ * Runs f in the thread of o without waiting for it. The future is canceled if
+ * o is destroyed or the event is discarded before f runs.
+ *
+ * @brief run_in_thread_async
+ * @param o
+ * @param f
+ * @return A future reporting the result of f.
+ */
+template<typename F, typename T = std::invoke_result_t<std::decay_t<F>&>>
+QFuture<T> run_in_thread_async(QObject* o, F&& f)
+{
+    QFutureInterface<T> promise;
+    promise.reportStarted();
+    QFuture<T> future = promise.future();
+    ThreadDispatcher::post(o->thread(), [guard = PromiseGuard<T>(promise), context = QPointer<QObject>(o), f = std::forward<F>(f)] () mutable {
+        if (!context)
+            guard.promise().reportCanceled();
+        else if constexpr (std::is_void_v<T>)
+            f();
+        else
+            guard.promise().reportResult(f());
+        guard.finish();
+    });
+    return future;
+}
+
+/**
+ * Runs f in the thread of context when future finishes, passing the result of
+ * future if it has one. Returns a future reporting the result of f, so
+ * continuations can be chained. If future is canceled or context is
+ * destroyed first, f is not called and the returned future is canceled.
+ *
+ * @brief then
+ * @param future
+ * @param context
+ * @param f
+ * @return
+ */
+template<typename T, typename F>
+auto then(const QFuture<T>& future, QObject* context, F&& f)
+{
+    using R = typename std::conditional_t<std::is_void_v<T>,
+        std::invoke_result<std::decay_t<F>&>,
+        std::invoke_result<std::decay_t<F>&, T>>::type;
+
+    QFutureInterface<R> promise;
+    promise.reportStarted();
+    QFuture<R> ret = promise.future();
+
+    QFutureWatcher<T>* watcher = new QFutureWatcher<T>;
+    QObject::connect(context, &QObject::destroyed, watcher, &QObject::deleteLater);
+    QObject::connect(watcher, &QObject::destroyed, [promise] () mutable {
+        if (promise.isFinished())
+            return;
+        promise.reportCanceled();
+        promise.reportFinished();
     });
+    QObject::connect(watcher, &QFutureWatcherBase::finished, context, [watcher, promise, f = std::forward<F>(f)] () mutable {
+        const QFuture<T> source = watcher->future();
+        if (source.isCanceled())
+            promise.reportCanceled();
+        else if constexpr (std::is_void_v<T> && std::is_void_v<R>)
+            f();
+        else if constexpr (std::is_void_v<T>)
+            promise.reportResult(f());
+        else if constexpr (std::is_void_v<R>)
+            f(source.result());
+        else
+            promise.reportResult(f(source.result()));
+        promise.reportFinished();
+        watcher->deleteLater();
+    });
+    // QFutureWatcher is not thread-safe: the future is set while the watcher
+    // still belongs to this thread, its pending events move along with it.
+    watcher->setFuture(future);
+    watcher->moveToThread(context->thread());
+
+    return ret;
+}
+
+#ifdef LQT_HAS_COROUTINES
+template<typename T = void> class Task;
+
+/**
+ * @brief The TaskPromiseBase class is the common part of the promise types of
+ * Task.
+ * The coroutine starts immediately and its frame is released when both the
+ * coroutine has finished and the Task has been destroyed, in any order.
+ */
+template<typename T>
+class TaskPromiseBase
+{
+public:
+    enum State { Running, Awaited, Detached, Done };
+
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    auto final_suspend() noexcept {
+        struct FinalAwaiter
+        {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> h) noexcept {
+                TaskPromiseBase* promise = m_promise;
+                const int prev = promise->m_state.exchange(Done, std::memory_order_acq_rel);
+                if (prev == Awaited)
+                    return promise->m_continuation;
+                if (prev == Detached)
+                    h.destroy();
+                return std::noop_coroutine();
+            }
+            void await_resume() noexcept {}
+            TaskPromiseBase* m_promise;
+        };
+        return FinalAwaiter { this };
+    }
+    void unhandled_exception() { m_exception = std::current_exception(); }
+
+    /**
+     * Finishes the coroutine suspended in h with an exception without resuming
+     * it, used when the event that should have resumed it was discarded. The
+     * frame is destroyed if the Task was already destroyed, an awaiting
+     * coroutine is resumed and gets the exception from co_await.
+     */
+    void abandon(std::coroutine_handle<> h) {
+        m_exception = std::make_exception_ptr(std::runtime_error("coroutine abandoned: its thread exited before resuming it"));
+        const int prev = m_state.exchange(Done, std::memory_order_acq_rel);
+        if (prev == Awaited)
+            m_continuation.resume();
+        else if (prev == Detached)
+            h.destroy();
+    }
+
+protected:
+    template<typename U> friend class Task;
+
+    std::atomic<int> m_state { Running };
+    std::coroutine_handle<> m_continuation;
+    std::exception_ptr m_exception;
+};
+
+template<typename T>
+class TaskPromise : public TaskPromiseBase<T>
+{
+public:
+    Task<T> get_return_object();
+    template<typename U> void return_value(U&& value) { m_value.emplace(std::forward<U>(value)); }
+    T result() {
+        if (this->m_exception)
+            std::rethrow_exception(this->m_exception);
+        return std::move(*m_value);
+    }
+
+private:
+    std::optional<T> m_value;
+};
+
+template<>
+class TaskPromise<void> : public TaskPromiseBase<void>
+{
+public:
+    Task<void> get_return_object();
+    void return_void() {}
+    void result() {
+        if (m_exception)
+            std::rethrow_exception(m_exception);
+    }
+};
+
+/**
+ * @brief The Task class is the return type of coroutines that can be awaited
+ * by other coroutines, producing a value of type T. The awaiting coroutine is
+ * resumed in the thread where the Task finished, or right away if it had
+ * already finished. Destroying the Task does not cancel the coroutine, which
+ * keeps running detached.
+ */
+template<typename T>
+class Task
+{
+public:
+    using promise_type = TaskPromise<T>;
+
+    Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            release();
+            m_handle = std::exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+    ~Task() { release(); }
+
+    bool isDone() const {
+        return !m_handle || m_handle.promise().m_state.load(std::memory_order_acquire) == promise_type::Done;
+    }
+
+    bool await_ready() const noexcept { return isDone(); }
+    bool await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        m_handle.promise().m_continuation = awaiting;
+        int expected = promise_type::Running;
+        return m_handle.promise().m_state.compare_exchange_strong(expected, promise_type::Awaited, std::memory_order_acq_rel);
+    }
+    T await_resume() { return m_handle.promise().result(); }
+
+private:
+    Q_DISABLE_COPY(Task)
+    friend class TaskPromise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+    void release() {
+        if (!m_handle)
+            return;
+        if (m_handle.promise().m_state.exchange(promise_type::Detached, std::memory_order_acq_rel) == promise_type::Done)
+            m_handle.destroy();
+        m_handle = {};
+    }
+
+private:
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+template<typename T>
+Task<T> TaskPromise<T>::get_return_object()
+{
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object()
+{
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+template<typename P> struct is_task_promise : std::false_type {};
+template<typename T> struct is_task_promise<TaskPromise<T>> : std::true_type {};
+
+/**
+ * @brief The ResumeGuard class resumes a suspended coroutine once. If it is
+ * destroyed without resuming, for instance because the event carrying it was
+ * discarded, a Task coroutine is abandoned and any other coroutine frame is
+ * destroyed, so it is not leaked.
+ */
+template<typename P>
+class ResumeGuard
+{
+public:
+    explicit ResumeGuard(std::coroutine_handle<P> handle) : m_handle(handle) {}
+    ResumeGuard(ResumeGuard&& other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+    ResumeGuard(const ResumeGuard&) = delete;
+    ResumeGuard& operator=(const ResumeGuard&) = delete;
+    ~ResumeGuard() {
+        if (!m_handle)
+            return;
+        if constexpr (is_task_promise<P>::value)
+            m_handle.promise().abandon(m_handle);
+        else
+            m_handle.destroy();
+    }
+
+    void resume() { std::exchange(m_handle, {}).resume(); }
+
+private:
+    std::coroutine_handle<P> m_handle;
+};
+
+/**
+ * @brief The ThreadAwaiter class is returned by resume_on(QThread*).
+ */
+struct ThreadAwaiter
+{
+    bool await_ready() const noexcept { return QThread::currentThread() == m_thread; }
+    template<typename P> void await_suspend(std::coroutine_handle<P> h) {
+        ThreadDispatcher::post(m_thread, [guard = ResumeGuard<P>(h)] () mutable { guard.resume(); });
+    }
+    void await_resume() const noexcept {}
+    QThread* m_thread;
+};
+
+/**
+ * @brief The ObjectAwaiter class is returned by resume_on(QObject*).
+ */
+struct ObjectAwaiter
+{
+    bool await_ready() const noexcept { return QThread::currentThread() == m_thread; }
+    template<typename P> void await_suspend(std::coroutine_handle<P> h) {
+        ThreadDispatcher::post(m_thread, [guard = ResumeGuard<P>(h)] () mutable { guard.resume(); });
+    }
+    bool await_resume() const noexcept { return !m_object.isNull(); }
+    QPointer<QObject> m_object;
+    QThread* m_thread;
+};
+
+/**
+ * Awaiting the returned object resumes the coroutine in the event loop of t,
+ * or immediately when already running in t. If t exits before the coroutine
+ * is resumed, a Task is finished with an exception and any other coroutine
+ * is destroyed.
+ *
+ * @brief resume_on
+ * @param t
+ * @return
+ */
+inline ThreadAwaiter resume_on(QThread* t)
+{
+    return ThreadAwaiter { t };
+}
+
+/**
+ * Awaiting the returned object resumes the coroutine in the thread of o. The
+ * result of co_await is false if o was destroyed meanwhile; in that case the
+ * coroutine is resumed in the thread o lived in.
+ *
+ * @brief resume_on
+ * @param o
+ * @return
+ */
+inline ObjectAwaiter resume_on(QObject* o)
+{
+    return ObjectAwaiter { o, o->thread() };
 }
+#endif // LQT_HAS_COROUTINES
 
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
 class RecursiveMutex : public QMutex
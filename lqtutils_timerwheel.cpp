@@ -0,0 +1,274 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Luca Carlon
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#include <QTimer>
+#include <QThreadStorage>
+
+#include <limits>
+
+#include "lqtutils_timerwheel.h"
+
+namespace lqt {
+
+// Generations are limited so that handles are exactly representable as
+// doubles in QML.
+static constexpr quint32 LQT_WHEEL_MAX_GENERATION = (1u << 21) - 1;
+
+TimerWheel::TimerWheel(int resolution, QObject* parent) :
+    QObject(parent)
+  , m_resolution(qMax(1, resolution))
+  , m_now(0)
+  , m_nextDue(0)
+  , m_pending(0)
+  , m_free(-1)
+{
+    for (int& list : m_lists)
+        list = -1;
+
+    m_clock.start();
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(m_resolution < 20 ? Qt::PreciseTimer : Qt::CoarseTimer);
+    connect(m_timer, &QTimer::timeout,
+            this, &TimerWheel::tick);
+}
+
+/**
+ * Returns the wheel of the current thread, with a resolution of 1 ms. It is
+ * created the first time it is used and destroyed when the thread exits.
+ *
+ * @brief TimerWheel::instance
+ * @return
+ */
+TimerWheel* TimerWheel::instance()
+{
+    static QThreadStorage<TimerWheel*> wheels;
+    if (!wheels.hasLocalData())
+        wheels.setLocalData(new TimerWheel);
+    return wheels.localData();
+}
+
+/**
+ * Cancels the callback identified by handle. Returns false if it already ran
+ * or was canceled.
+ *
+ * @brief TimerWheel::cancel
+ * @param handle
+ * @return
+ */
+bool TimerWheel::cancel(Handle handle)
+{
+    if (!isScheduled(handle))
+        return false;
+
+    const int index = int(handle & 0xFFFFFFFF);
+    unlink(index);
+    release(index);
+    return true;
+}
+
+bool TimerWheel::isScheduled(Handle handle) const
+{
+    const quint64 index = handle & 0xFFFFFFFF;
+    if (index >= m_nodes.size())
+        return false;
+
+    const Node& node = m_nodes[index];
+    return node.list >= 0 && node.generation == quint32(handle >> 32);
+}
+
+void TimerWheel::tick()
+{
+    const quint64 target = currentTick();
+    while (m_now < target && m_pending) {
+        m_now++;
+
+        // Moves the callbacks of the next higher slot down when a level wraps.
+        for (int level = 1; level < Levels; level++) {
+            if ((m_now >> (SlotBits*(level - 1))) & (Slots - 1))
+                break;
+            cascade(level);
+        }
+
+        // Callbacks may schedule or cancel others, including the ones in the
+        // slot being processed, so they are moved to a separate list first.
+        const int slot = int(m_now & (Slots - 1));
+        while (m_lists[slot] >= 0) {
+            const int index = m_lists[slot];
+            unlink(index);
+            link(index, RunningList);
+        }
+        while (m_lists[RunningList] >= 0) {
+            const int index = m_lists[RunningList];
+            UniqueFunction<void()> f = std::move(m_nodes[index].f);
+            unlink(index);
+            release(index);
+            f();
+        }
+    }
+
+    if (!m_pending)
+        m_now = qMax(m_now, target);
+    updateTimer();
+}
+
+int TimerWheel::allocNode()
+{
+    if (m_free < 0) {
+        m_nodes.emplace_back();
+        return int(m_nodes.size() - 1);
+    }
+
+    const int index = m_free;
+    m_free = m_nodes[index].next;
+    return index;
+}
+
+TimerWheel::Handle TimerWheel::add(int msec, UniqueFunction<void()>&& f)
+{
+    if (!f)
+        return 0;
+
+    // An idle wheel has no slots to process, so it can skip to the current
+    // tick instead of walking all the elapsed ones in the next tick().
+    if (!m_pending)
+        m_now = qMax(m_now, currentTick());
+
+    // Rounded up, so callbacks never run early. Expired ticks may not have
+    // been processed yet, so the expiry must also follow m_now.
+    const quint64 due = quint64(m_clock.elapsed()) + quint64(qMax(0, msec));
+    const quint64 expiry = qMax((due + m_resolution - 1)/m_resolution, m_now + 1);
+
+    const int index = allocNode();
+    Node& node = m_nodes[index];
+    node.f = std::move(f);
+    node.expiry = expiry;
+    insert(index);
+    m_pending++;
+
+    if (!m_timer->isActive() || expiry < m_nextDue) {
+        m_nextDue = expiry;
+        const qint64 interval = qint64(expiry)*m_resolution - m_clock.elapsed();
+        m_timer->start(int(qBound<qint64>(0, interval, std::numeric_limits<int>::max())));
+    }
+
+    return (quint64(node.generation) << 32) | quint64(index);
+}
+
+/**
+ * Adds the node to the slot of its expiry, relative to the current tick.
+ */
+void TimerWheel::insert(int index)
+{
+    const quint64 expiry = qMax(m_nodes[index].expiry, m_now);
+    const quint64 delta = expiry - m_now;
+    int level = 0;
+    while (level < Levels - 1 && delta >= (quint64(1) << (SlotBits*(level + 1))))
+        level++;
+
+    // Longer delays are clamped to the last slot of the highest level.
+    quint64 e = expiry;
+    if (delta >= (quint64(1) << (SlotBits*Levels)))
+        e = m_now + (quint64(1) << (SlotBits*Levels)) - 1;
+
+    const int slot = int((e >> (SlotBits*level)) & (Slots - 1));
+    link(index, level*Slots + slot);
+}
+
+void TimerWheel::link(int index, int list)
+{
+    Node& node = m_nodes[index];
+    node.list = list;
+    node.prev = -1;
+    node.next = m_lists[list];
+    if (node.next >= 0)
+        m_nodes[node.next].prev = index;
+    m_lists[list] = index;
+}
+
+void TimerWheel::unlink(int index)
+{
+    Node& node = m_nodes[index];
+    if (node.prev >= 0)
+        m_nodes[node.prev].next = node.next;
+    else
+        m_lists[node.list] = node.next;
+    if (node.next >= 0)
+        m_nodes[node.next].prev = node.prev;
+    node.list = -1;
+    node.prev = -1;
+    node.next = -1;
+}
+
+void TimerWheel::release(int index)
+{
+    Node& node = m_nodes[index];
+    node.f = nullptr;
+    node.generation = node.generation >= LQT_WHEEL_MAX_GENERATION ? 1 : node.generation + 1;
+    node.next = m_free;
+    m_free = index;
+    m_pending--;
+}
+
+void TimerWheel::cascade(int level)
+{
+    const int slot = int((m_now >> (SlotBits*level)) & (Slots - 1));
+    const int list = level*Slots + slot;
+    while (m_lists[list] >= 0) {
+        const int index = m_lists[list];
+        unlink(index);
+        insert(index);
+    }
+}
+
+quint64 TimerWheel::currentTick() const
+{
+    return quint64(m_clock.elapsed())/m_resolution;
+}
+
+/**
+ * Arms the Qt timer for the next slot holding callbacks, or for the next
+ * cascade if the first level is empty.
+ */
+void TimerWheel::updateTimer()
+{
+    if (!m_pending) {
+        m_timer->stop();
+        return;
+    }
+
+    quint64 due = (m_now | (Slots - 1)) + 1;
+    for (quint64 t = m_now + 1; t < due; t++) {
+        if (m_lists[t & (Slots - 1)] >= 0) {
+            due = t;
+            break;
+        }
+    }
+
+    m_nextDue = due;
+    const qint64 interval = qint64(due)*m_resolution - m_clock.elapsed();
+    m_timer->start(int(qBound<qint64>(0, interval, std::numeric_limits<int>::max())));
+}
+
+} // namespace
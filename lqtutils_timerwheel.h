@@ -0,0 +1,121 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Luca Carlon
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef LQTUTILS_TIMERWHEEL_H
+#define LQTUTILS_TIMERWHEEL_H
+
+#include <QObject>
+#include <QElapsedTimer>
+
+#include <vector>
+
+#include "lqtutils_function.h"
+
+QT_FORWARD_DECLARE_CLASS(QTimer);
+
+namespace lqt {
+
+/**
+ * @brief The TimerWheel class runs many single shot callbacks with a single
+ * Qt timer. Callbacks are kept in a hierarchical wheel of four levels with 256
+ * slots each, so scheduling and canceling are O(1) and delays up to 2^32 ticks
+ * are supported. The Qt timer only fires when a slot needs to be processed.
+ * Callbacks run in the thread of the wheel, which must also be the thread
+ * calling schedule() and cancel(). instance() returns a wheel for each thread.
+ */
+class TimerWheel : public QObject
+{
+    Q_OBJECT
+public:
+    typedef quint64 Handle;
+
+    explicit TimerWheel(int resolution = 1, QObject* parent = nullptr);
+
+    static TimerWheel* instance();
+
+    template<typename F> Handle schedule(int msec, F&& f);
+    bool cancel(Handle handle);
+    bool isScheduled(Handle handle) const;
+    int pendingCount() const { return m_pending; }
+    int resolution() const { return m_resolution; }
+
+private slots:
+    void tick();
+
+private:
+    static constexpr int Levels = 4;
+    static constexpr int SlotBits = 8;
+    static constexpr int Slots = 1 << SlotBits;
+    // List of the callbacks being run by tick().
+    static constexpr int RunningList = Levels*Slots;
+
+    struct Node
+    {
+        UniqueFunction<void()> f;
+        quint64 expiry = 0;
+        int prev = -1;
+        int next = -1;
+        int list = -1;
+        quint32 generation = 1;
+    };
+
+    int allocNode();
+    Handle add(int msec, UniqueFunction<void()>&& f);
+    void insert(int index);
+    void link(int index, int list);
+    void unlink(int index);
+    void release(int index);
+    void cascade(int level);
+    quint64 currentTick() const;
+    void updateTimer();
+
+private:
+    const int m_resolution;
+    QElapsedTimer m_clock;
+    QTimer* m_timer;
+    quint64 m_now;
+    quint64 m_nextDue;
+    int m_pending;
+    int m_free;
+    std::vector<Node> m_nodes;
+    int m_lists[Levels*Slots + 1];
+};
+
+/**
+ * Calls f after msec ms and returns a handle that can be used to cancel it.
+ *
+ * @brief TimerWheel::schedule
+ * @param msec
+ * @param f
+ * @return
+ */
+template<typename F>
+TimerWheel::Handle TimerWheel::schedule(int msec, F&& f)
+{
+    return add(msec, UniqueFunction<void()>(std::forward<F>(f)));
+}
+
+} // namespace
+
+#endif // LQTUTILS_TIMERWHEEL_H
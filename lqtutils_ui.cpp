@@ -24,6 +24,7 @@
 
 #include <QBuffer>
 #include <QTimer>
+#include <QThread>
 #include <QQuickWindow>
 #include <QMutableListIterator>
 #include <QGuiApplication>
@@ -153,13 +154,69 @@ QMetaObject::Connection enableAutoFrameUpdates(QQuickWindow& w)
 }
 
 
-void QmlUtils::singleShot(int msec, QJSValue callback)
+QmlUtils::~QmlUtils()
 {
-    QTimer::singleShot(msec, this, [callback] () mutable
+    for (const Timeout& timeout : std::as_const(m_timeouts))
+        cancelTimeout(timeout);
+}
+
+/**
+ * Calls callback after msec ms using the timer wheel of the thread of this
+ * object, so no Qt timer is created for each call. Returns a handle that can
+ * be passed to cancelSingleShot(). Both must be called from the thread of this
+ * object, as the callbacks update the handles without locking.
+ */
+double QmlUtils::singleShot(int msec, QJSValue callback)
+{
+    Q_ASSERT(QThread::currentThread() == thread());
+    if (!callback.isCallable())
+        return 0;
+
+    const quint64 id = ++m_lastTimeout;
+    TimerWheel* wheel = TimerWheel::instance();
+    QPointer<QmlUtils> self(this);
+    m_timeouts.insert(id, Timeout { wheel, wheel->schedule(msec, [self, id, callback] () mutable
     {
-        if (callback.isCallable())
-            callback.call();
-    });
+        // A cancel posted from another thread may not have run yet.
+        if (!self)
+            return;
+        self->m_timeouts.remove(id);
+        callback.call();
+    }) });
+    return double(id);
+}
+
+bool QmlUtils::cancelSingleShot(double handle)
+{
+    Q_ASSERT(QThread::currentThread() == thread());
+    const auto it = m_timeouts.find(quint64(handle));
+    if (it == m_timeouts.end())
+        return false;
+
+    cancelTimeout(it.value());
+    m_timeouts.erase(it);
+    return true;
+}
+
+/**
+ * Cancels the callback in the wheel it was scheduled on. Wheels are not
+ * thread-safe, so the request is posted when the wheel belongs to another
+ * thread.
+ */
+void QmlUtils::cancelTimeout(const Timeout& timeout)
+{
+    TimerWheel* wheel = timeout.wheel;
+    if (!wheel)
+        return;
+    if (wheel->thread() == QThread::currentThread()) {
+        wheel->cancel(timeout.handle);
+        return;
+    }
+
+    const TimerWheel::Handle handle = timeout.handle;
+    QMetaObject::invokeMethod(wheel, [wheel, handle] {
+        wheel->cancel(handle);
+    }, Qt::QueuedConnection);
 }
 
 #ifndef Q_OS_IOS
@@ -33,11 +33,14 @@
 #include <QMetaObject>
 #include <QImage>
 #include <QMap>
+#include <QHash>
 #include <QVariant>
 #include <QString>
+#include <QPointer>
 
 #include "lqtutils_freq.h"
 #include "lqtutils_prop.h"
+#include "lqtutils_timerwheel.h"
 
 QT_FORWARD_DECLARE_CLASS(QQuickWindow);
 
@@ -71,9 +74,11 @@ class QmlUtils : public QObject
 {
     Q_OBJECT
 public:
-    QmlUtils(QObject* parent = nullptr) : QObject(parent) {}
+    QmlUtils(QObject* parent = nullptr) : QObject(parent), m_lastTimeout(0) {}
+    ~QmlUtils();
 
-    Q_INVOKABLE void singleShot(int msec, QJSValue callback);
+    Q_INVOKABLE double singleShot(int msec, QJSValue callback);
+    Q_INVOKABLE bool cancelSingleShot(double handle);
     Q_INVOKABLE static double safeAreaBottomInset();
     Q_INVOKABLE static double safeAreaTopInset();
     Q_INVOKABLE static double safeAreaRightInset();
@@ -86,6 +91,19 @@ public:
     Q_INVOKABLE static bool setBarColorLight(bool light, bool fullscreen);
     Q_INVOKABLE static bool setNavBarColor(const QColor& color);
     Q_INVOKABLE static bool setStatusBarColor(const QColor& color);
+
+private:
+    struct Timeout
+    {
+        QPointer<TimerWheel> wheel;
+        TimerWheel::Handle handle;
+    };
+    static void cancelTimeout(const Timeout& timeout);
+
+private:
+    // Handles returned to QML mapped to the handles of the timer wheel.
+    QHash<quint64, Timeout> m_timeouts;
+    quint64 m_lastTimeout;
 };
 
 /**
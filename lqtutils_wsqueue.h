@@ -0,0 +1,232 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2026 Luca Carlon
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifndef LQTUTILS_WSQUEUE_H
+#define LQTUTILS_WSQUEUE_H
+
+#include <QString>
+#include <QMutex>
+#include <QDeadlineTimer>
+
+#include <atomic>
+#include <memory>
+#include <optional>
+
+#include "lqtutils_bqueue.h"
+#include "lqtutils_lfqueue.h"
+
+namespace lqt {
+
+/**
+ * @brief The WorkStealingQueue class is a bounded queue split in one shard per
+ * consumer. Producers push round robin, or to a specific shard when the
+ * element has an affinity, and each consumer takes from the front of its own
+ * shard. When its shard is empty, a consumer steals from the back of the
+ * others. Consumers only contend when stealing, and a producer wakes up a
+ * single parked consumer. Timeouts, dispose and std::optional results work
+ * like in lqt::BlockingQueue; the consumer passes the index of its shard.
+ */
+template<typename T>
+class WorkStealingQueue
+{
+public:
+    WorkStealingQueue(int shards, int capacity, const QString& name = QString());
+
+    bool enqueue(const T& e, qint64 timeout = -1) { return push(nextShard(), e, timeout); }
+    bool enqueue(T&& e, qint64 timeout = -1) { return push(nextShard(), std::move(e), timeout); }
+    bool enqueueTo(int shard, const T& e, qint64 timeout = -1) { return push(shard, e, timeout); }
+    bool enqueueTo(int shard, T&& e, qint64 timeout = -1) { return push(shard, std::move(e), timeout); }
+    std::optional<T> dequeue(int shard, qint64 timeout = -1);
+    std::optional<T> tryDequeue(int shard);
+    int size() const { return m_available.load(std::memory_order_acquire); }
+    int capacity() const { return m_capacity; }
+    int shardCount() const { return m_shardCount; }
+    bool isEmpty() const { return size() == 0; }
+    bool isDisposed() const { return m_disposed.load(std::memory_order_acquire); }
+    void requestDispose();
+    QString name() const { return m_name; }
+    qint64 stolenCount() const { return m_stolen.load(std::memory_order_relaxed); }
+
+private:
+    Q_DISABLE_COPY(WorkStealingQueue)
+
+    struct alignas(LC_CACHE_LINE_SIZE) Shard
+    {
+        QMutex mutex;
+        RingBuffer<T> items;
+    };
+
+    int nextShard() { return static_cast<int>(m_next.fetch_add(1, std::memory_order_relaxed) % quint32(m_shardCount)); }
+    bool tryReserve();
+    template<typename U> bool push(int shard, U&& e, qint64 timeout);
+    std::optional<T> take(int shard, bool steal);
+
+private:
+    const int m_shardCount;
+    const int m_capacity;
+    const QString m_name;
+    std::unique_ptr<Shard[]> m_shards;
+    std::atomic<quint32> m_next;
+    alignas(LC_CACHE_LINE_SIZE) std::atomic<int> m_reserved;
+    alignas(LC_CACHE_LINE_SIZE) std::atomic<int> m_available;
+    std::atomic<qint64> m_stolen;
+    std::atomic<bool> m_disposed;
+    EventCount m_notEmpty;
+    EventCount m_notFull;
+};
+
+template<typename T>
+WorkStealingQueue<T>::WorkStealingQueue(int shards, int capacity, const QString& name) :
+    m_shardCount(qMax(1, shards))
+  , m_capacity(capacity)
+  , m_name(name)
+  , m_shards(new Shard[qMax(1, shards)])
+  , m_next(0)
+  , m_reserved(0)
+  , m_available(0)
+  , m_stolen(0)
+  , m_disposed(false)
+{
+    const int shardCapacity = qMin(capacity/m_shardCount + 1, LQT_BQUEUE_MAX_PREALLOC);
+    for (int i = 0; i < m_shardCount; i++)
+        m_shards[i].items.reserve(shardCapacity);
+}
+
+/**
+ * Reserves room for one element in the whole queue.
+ */
+template<typename T>
+bool WorkStealingQueue<T>::tryReserve()
+{
+    int reserved = m_reserved.load(std::memory_order_relaxed);
+    while (reserved < m_capacity) {
+        if (m_reserved.compare_exchange_weak(reserved, reserved + 1, std::memory_order_acquire))
+            return true;
+    }
+
+    return false;
+}
+
+template<typename T>
+template<typename U>
+bool WorkStealingQueue<T>::push(int shard, U&& e, qint64 timeout)
+{
+    Q_ASSERT(shard >= 0 && shard < m_shardCount);
+    if (isDisposed())
+        return false;
+
+    if (!tryReserve()) {
+        if (!timeout)
+            return false;
+
+        const QDeadlineTimer deadline(timeout);
+        while (!tryReserve()) {
+            const bool ready = m_notFull.wait([this] {
+                return isDisposed() || m_reserved.load(std::memory_order_relaxed) < m_capacity;
+            }, deadline, LQT_LFQUEUE_SPIN_COUNT);
+            if (!ready || isDisposed())
+                return false;
+        }
+    }
+
+    {
+        Shard& s = m_shards[shard];
+        QMutexLocker locker(&s.mutex);
+        s.items.append(std::forward<U>(e));
+        m_available.fetch_add(1, std::memory_order_release);
+    }
+
+    m_notEmpty.notifyOne();
+    return true;
+}
+
+/**
+ * Takes the first element of the shard, or the last one when stealing.
+ */
+template<typename T>
+std::optional<T> WorkStealingQueue<T>::take(int shard, bool steal)
+{
+    Shard& s = m_shards[shard];
+    QMutexLocker locker(&s.mutex);
+    if (s.items.isEmpty())
+        return std::nullopt;
+
+    std::optional<T> ret(steal ? s.items.takeLast() : s.items.takeFirst());
+    m_available.fetch_sub(1, std::memory_order_relaxed);
+    return ret;
+}
+
+template<typename T>
+std::optional<T> WorkStealingQueue<T>::tryDequeue(int shard)
+{
+    Q_ASSERT(shard >= 0 && shard < m_shardCount);
+    std::optional<T> ret = take(shard, false);
+    for (int i = 1; !ret && i < m_shardCount && m_available.load(std::memory_order_acquire) > 0; i++) {
+        ret = take((shard + i) % m_shardCount, true);
+        if (ret)
+            m_stolen.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (ret) {
+        m_reserved.fetch_sub(1, std::memory_order_release);
+        m_notFull.notifyOne();
+    }
+
+    return ret;
+}
+
+template<typename T>
+std::optional<T> WorkStealingQueue<T>::dequeue(int shard, qint64 timeout)
+{
+    if (isDisposed())
+        return std::nullopt;
+
+    std::optional<T> ret = tryDequeue(shard);
+    if (ret || !timeout)
+        return ret;
+
+    const QDeadlineTimer deadline(timeout);
+    while (!ret) {
+        const bool ready = m_notEmpty.wait([this] {
+            return isDisposed() || m_available.load(std::memory_order_acquire) > 0;
+        }, deadline, LQT_LFQUEUE_SPIN_COUNT);
+        if (!ready || isDisposed())
+            return std::nullopt;
+        ret = tryDequeue(shard);
+    }
+
+    return ret;
+}
+
+template<typename T>
+void WorkStealingQueue<T>::requestDispose()
+{
+    m_disposed.store(true, std::memory_order_seq_cst);
+    m_notEmpty.notifyAll();
+    m_notFull.notifyAll();
+}
+
+} // namespace
+
+#endif // LQTUTILS_WSQUEUE_H